@@ -0,0 +1,1355 @@
+/* FramI2CBenchmark.cpp
+ *
+ * Description:  Host benchmark for FramI2C.
+ *               Runs FramI2C operations against simulated FRAM chips (FramI2CSimBus) and reports
+ *               the modeled I2C bus time of every operation, for all supported densities and bus speeds.
+ *
+ *               Usage: FramI2CBenchmark [-t]
+ *                 -t   Trace every I2C transaction.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "FramI2C.h"
+#include "FramI2CAsync.h"
+#include "FramI2CCrc.h"
+#include "FramI2CFixed.h"
+#include "FramI2CSerializer.h"
+#include "FramI2CSimBus.h"
+#include "FramImageDecoder.h"
+#include "FramMirror.h"
+#include "FramReadCache.h"
+#include "FramStripe.h"
+#include "FramWriteCache.h"
+#include "FramWriteQueue.h"
+
+
+static const uint16_t Densities[] = {4, 16, 64, 128, 256, 512, 1024};
+
+static const FramI2CSimBus::Speed Speeds[] =
+{
+    FramI2CSimBus::Speed::StandardMode,
+    FramI2CSimBus::Speed::FastMode,
+    FramI2CSimBus::Speed::FastModePlus,
+    FramI2CSimBus::Speed::HighSpeedMode
+};
+
+static FILE* trace = nullptr;
+
+
+static uint32_t exampleDeviceId(const uint16_t density)
+{
+    // Device IDs of chips with the given density (0 if such chips do not support a device ID).
+    switch (density)
+    {
+        case 64:   return 0x00A358;     // Fujitsu MB85RC64TA
+        case 128:  return 0x004100;     // Cypress FM24V01
+        case 256:  return 0x004200;     // Cypress FM24V02
+        case 512:  return 0x004300;     // Cypress FM24V05
+        case 1024: return 0x004400;     // Cypress FM24V10
+        default:   return 0;
+    }
+}
+
+
+static void report(const char* const operation, const FramI2CSimBus& bus, const size_t byteCount, const FramI2C::ResultCode resultcode)
+{
+    double micros = bus.elapsedNanos() / 1000.0;
+    double kiloBytesPerSecond = (micros > 0) ? byteCount * 1000.0 / micros : 0.0;
+    printf("    %-28s %7zu B %6u trans %12.1f us %9.1f kB/s%s\n",
+        operation, byteCount, bus.transactionCount(), micros, kiloBytesPerSecond,
+        resultcode == FramI2C::ResultCode::Success ? "" : "  (FAILED)");
+}
+
+
+static void benchmarkOperations(void)
+{
+    printf("Basic operations (one page, max 4 KB)\n");
+    for (uint16_t density : Densities)
+    {
+        for (FramI2CSimBus::Speed speed : Speeds)
+        {
+            FramI2CSimDevice chip(density, 0x50, exampleDeviceId(density));
+            FramI2CSimBus bus(32, speed);
+            bus.attach(chip);
+            bus.setTrace(trace);
+            FramI2C fram;
+            fram.begin(bus, density);
+
+            size_t byteCount = (fram.pageSize() < 4096) ? fram.pageSize() : 4096;
+            std::vector<uint8_t> data(byteCount);
+            for (size_t i = 0; i < byteCount; ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7);
+            }
+
+            printf("  %4u kb @ %s\n", density, FramI2CSimBus::speedName(speed));
+            FramI2C::ResultCode resultcode;
+
+            bus.resetStatistics();
+            resultcode = fram.writeBytes(0, 0, byteCount, data.data());
+            report("writeBytes", bus, byteCount, resultcode);
+
+            bus.resetStatistics();
+            resultcode = fram.readBytes(0, 0, byteCount, data.data());
+            report("readBytes", bus, byteCount, resultcode);
+
+            bus.resetStatistics();
+            resultcode = fram.fill(0, 0, byteCount, 0xFF);
+            report("fill", bus, byteCount, resultcode);
+
+            uint32_t value = 0xBABE;
+            bus.resetStatistics();
+            resultcode = fram.write(0, 0, value);
+            report("write<uint32_t>", bus, sizeof(value), resultcode);
+
+            bus.resetStatistics();
+            resultcode = fram.read(0, 0, value);
+            report("read<uint32_t>", bus, sizeof(value), resultcode);
+
+            bus.resetStatistics();
+            bool supported = fram.isDeviceIdSupported();
+            report("device ID", bus, supported ? 3 : 0, FramI2C::ResultCode::Success);
+        }
+    }
+    printf("\n");
+}
+
+
+static void benchmarkChunkSize(void)
+{
+    // 4 KB transfers to a 64 kb FRAM (2 address bytes) with different I2C buffer lengths.
+    // Gain is relative to the AVR Wire buffer length (32).
+
+    static const size_t BufferLengths[] = {32, 64, 128, 256};
+    const size_t byteCount = 4096;
+    std::vector<uint8_t> data(byteCount, 0x5A);
+
+    printf("Chunk size (4 KB transfers, 64 kb FRAM)\n");
+    for (FramI2CSimBus::Speed speed : Speeds)
+    {
+        printf("  %s\n", FramI2CSimBus::speedName(speed));
+        double writeBaseline = 0.0;
+        double readBaseline = 0.0;
+        for (size_t bufferLength : BufferLengths)
+        {
+            FramI2CSimDevice chip(64);
+            FramI2CSimBus bus(bufferLength, speed);
+            bus.attach(chip);
+            FramI2C fram;
+            fram.begin(bus, 64);
+
+            bus.resetStatistics();
+            fram.writeBytes(0, 0, byteCount, data.data());
+            double writeBytesPerSecond = byteCount * 1e9 / bus.elapsedNanos();
+            uint32_t writeTransactions = bus.transactionCount();
+
+            bus.resetStatistics();
+            fram.readBytes(0, 0, byteCount, data.data());
+            double readBytesPerSecond = byteCount * 1e9 / bus.elapsedNanos();
+            uint32_t readTransactions = bus.transactionCount();
+
+            if (bufferLength == BufferLengths[0])
+            {
+                writeBaseline = writeBytesPerSecond;
+                readBaseline = readBytesPerSecond;
+            }
+            printf("    buffer %3zu   write %9.0f B/s (%4u trans, %+5.1f%%)   read %9.0f B/s (%4u trans, %+5.1f%%)\n",
+                bufferLength,
+                writeBytesPerSecond, writeTransactions, (writeBytesPerSecond / writeBaseline - 1.0) * 100.0,
+                readBytesPerSecond, readTransactions, (readBytesPerSecond / readBaseline - 1.0) * 100.0);
+        }
+    }
+    printf("\n");
+}
+
+
+static void benchmarkStreamingRead(void)
+{
+    // Full 64 KB page dump (512 kb FRAM) with and without streaming read.
+
+    const size_t byteCount = 0x10000;
+    std::vector<uint8_t> data(byteCount);
+
+    printf("Streaming read (64 KB page, 512 kb FRAM, 32 byte buffer)\n");
+    for (FramI2CSimBus::Speed speed : Speeds)
+    {
+        double micros[2];
+        uint32_t transactions[2];
+        for (int streaming = 0; streaming < 2; ++streaming)
+        {
+            FramI2CSimDevice chip(512);
+            FramI2CSimBus bus(32, speed);
+            bus.attach(chip);
+            FramI2C fram;
+            fram.begin(bus, 512);
+            fram.setStreamingRead(streaming == 1);
+
+            bus.resetStatistics();
+            fram.readBytes(0, 0, byteCount, data.data());
+            micros[streaming] = bus.elapsedNanos() / 1000.0;
+            transactions[streaming] = bus.transactionCount();
+        }
+        printf("  %-8s  selective %10.0f us (%5u trans)   streaming %10.0f us (%5u trans)   %+5.1f%%\n",
+            FramI2CSimBus::speedName(speed), micros[0], transactions[0], micros[1], transactions[1],
+            (micros[0] / micros[1] - 1.0) * 100.0);
+    }
+    printf("\n");
+}
+
+
+static void benchmarkStripe(void)
+{
+    // 32 KB sequential write and read on a FramStripe with 256 byte stripes over 256 kb FRAM chips.
+    // On the host the buses are simulated one after the other, so concurrency is not measured. The
+    // "concurrent" times are an idealized model of ESP32 and RP2040 with FreeRTOS (where chips on separate
+    // buses are transferred concurrently, FRAMSTRIPE_CONCURRENT): the time of the busiest bus, without task
+    // switching and synchronization overhead. The "sequential" times are the sum of all buses, as on
+    // platforms without concurrency (e.g. AVR, RP2040 without FreeRTOS).
+
+    static const uint8_t ChipCounts[] = {1, 2, 4};
+    const size_t byteCount = 0x8000;
+    std::vector<uint8_t> data(byteCount, 0xA5);
+
+    printf("Striping (32 KB, 256 byte stripes, 256 kb FRAM, 1 bus per chip)\n");
+    printf("  concurrent: idealized model (busiest bus, no task overhead), sequential: sum of all buses\n");
+    for (FramI2CSimBus::Speed speed : Speeds)
+    {
+        printf("  %s\n", FramI2CSimBus::speedName(speed));
+        double baseline = 0.0;
+        for (uint8_t chipCount : ChipCounts)
+        {
+            std::vector<FramI2CSimDevice> chips(chipCount, FramI2CSimDevice(256));
+            std::vector<FramI2CSimBus> buses(chipCount, FramI2CSimBus(32, speed));
+            std::vector<FramI2C> frams(chipCount);
+            std::vector<FramI2C*> framPointers;
+            for (uint8_t i = 0; i < chipCount; ++i)
+            {
+                buses[i].attach(chips[i]);
+                frams[i].begin(buses[i], 256);
+                framPointers.push_back(&frams[i]);
+            }
+            FramStripe stripe;
+            stripe.begin(framPointers.data(), chipCount, 256);
+
+            double micros[2];
+            double sequentialMicros[2];
+            for (int operation = 0; operation < 2; ++operation)
+            {
+                for (FramI2CSimBus& bus : buses)
+                {
+                    bus.resetStatistics();
+                }
+                if (operation == 0)
+                {
+                    stripe.writeBytes(0, byteCount, data.data());
+                }
+                else
+                {
+                    stripe.readBytes(0, byteCount, data.data());
+                }
+                uint64_t busiest = 0;
+                uint64_t total = 0;
+                for (FramI2CSimBus& bus : buses)
+                {
+                    busiest = (bus.elapsedNanos() > busiest) ? bus.elapsedNanos() : busiest;
+                    total += bus.elapsedNanos();
+                }
+                micros[operation] = busiest / 1000.0;
+                sequentialMicros[operation] = total / 1000.0;
+            }
+            if (chipCount == ChipCounts[0])
+            {
+                baseline = micros[0] + micros[1];
+            }
+            printf("    %u chip(s)   concurrent (model) write %10.0f us   read %10.0f us   speedup %.2fx"
+                "   sequential speedup %.2fx\n",
+                chipCount, micros[0], micros[1], baseline / (micros[0] + micros[1]),
+                baseline / (sequentialMicros[0] + sequentialMicros[1]));
+        }
+    }
+    printf("\n");
+}
+
+
+static void benchmarkWriteCache(void)
+{
+    // Control loop that writes 24 float state variables every 10 ms during 1 second,
+    // directly via FramI2C and via FramWriteCache (8 lines of 32 bytes, flushed every 100 ms).
+
+    const uint8_t variableCount = 24;
+    const uint32_t tickMs = 10;
+    const uint32_t durationMs = 1000;
+
+    printf("Write cache (24 floats every 10 ms during 1 s, 64 kb FRAM @ 400 kHz)\n");
+    for (int cached = 0; cached < 2; ++cached)
+    {
+        FramI2CSimDevice chip(64);
+        FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+        bus.attach(chip);
+        FramI2C fram;
+        fram.begin(bus, 64);
+        FramWriteCache cache;
+        cache.begin(fram, 8, 32, 100);
+
+        bus.resetStatistics();
+        for (uint32_t now = 0; now < durationMs; now += tickMs)
+        {
+            for (uint8_t i = 0; i < variableCount; ++i)
+            {
+                float value = now * 0.001f + i;
+                if (cached)
+                {
+                    cache.write(i * sizeof(float), value);
+                }
+                else
+                {
+                    fram.write(i * sizeof(float), value);
+                }
+            }
+            if (cached)
+            {
+                cache.poll(now);
+            }
+        }
+        cache.end();
+
+        printf("  %-8s %6u trans %10.0f us", cached ? "cached" : "direct", bus.transactionCount(), bus.elapsedNanos() / 1000.0);
+        if (cached)
+        {
+            printf("   (%u writes, %u flushes, %u transactions saved)",
+                cache.statistics().writeCount, cache.statistics().flushCount, cache.statistics().savedTransactionCount());
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+
+static void benchmarkReadCache(void)
+{
+    // Two read patterns, directly via FramI2C and via FramReadCache (4 lines of 32 bytes)
+    // without and with prefetch:
+    //   parameters: 1000 reads of 16 uint32_t parameters in a 64 byte table, one parameter
+    //               is updated via FramI2C every 10 reads (invalidates its cache line).
+    //   sequential: 16 byte records of a 4 KB log are read one after the other.
+
+    printf("Read cache (4 lines of 32 bytes, 64 kb FRAM @ 400 kHz)\n");
+    for (int pattern = 0; pattern < 2; ++pattern)
+    {
+        for (int mode = 0; mode < 3; ++mode)
+        {
+            FramI2CSimDevice chip(64);
+            FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+            bus.attach(chip);
+            FramI2C fram;
+            fram.begin(bus, 64);
+            for (uint32_t i = 0; i < 4096; ++i)
+            {
+                chip.memory()[i] = static_cast<uint8_t>(i * 7);
+            }
+            FramReadCache cache;
+            cache.begin(fram, 4, 32, mode == 2);
+
+            bool ok = true;
+            bus.resetStatistics();
+            if (pattern == 0)
+            {
+                for (uint32_t i = 0; i < 1000; ++i)
+                {
+                    uint32_t address = ((i * 5) % 16) * sizeof(uint32_t);
+                    if (i % 10 == 0)
+                    {
+                        fram.write(address, i);
+                    }
+                    uint32_t value = 0;
+                    if (mode == 0)
+                    {
+                        fram.read(address, value);
+                    }
+                    else
+                    {
+                        cache.read(address, value);
+                    }
+                    uint32_t expected;
+                    memcpy(&expected, chip.memory() + address, sizeof(expected));
+                    ok = ok && value == expected;
+                }
+            }
+            else
+            {
+                uint8_t record[16];
+                for (uint32_t address = 0; address < 4096; address += sizeof(record))
+                {
+                    FramI2C::ResultCode resultcode = (mode == 0)
+                        ? fram.readBytes(address, sizeof(record), record)
+                        : cache.readBytes(address, sizeof(record), record);
+                    ok = ok && resultcode == FramI2C::ResultCode::Success && memcmp(record, chip.memory() + address, sizeof(record)) == 0;
+                }
+            }
+
+            static const char* const modeNames[] = {"direct", "cached", "prefetch"};
+            printf("  %-10s %-8s %6u trans %10.0f us", pattern == 0 ? "parameters" : "sequential", modeNames[mode],
+                bus.transactionCount(), bus.elapsedNanos() / 1000.0);
+            if (mode != 0)
+            {
+                printf("   (%u hits, %u misses, %u prefetched)",
+                    cache.statistics().hitCount, cache.statistics().missCount, cache.statistics().prefetchCount);
+            }
+            printf("%s\n", ok ? "" : "   FAILED");
+        }
+    }
+    printf("\n");
+}
+
+
+static void benchmarkArray(void)
+{
+    // float[512] and int16_t[2048] written and read per element with write()/read()
+    // and as a whole with writeArray()/readArray(), with and without byte order conversion.
+
+    printf("Typed arrays (float[512], int16_t[2048], 256 kb FRAM @ 400 kHz, 32 byte buffer)\n");
+    static float floats[512];
+    static int16_t shorts[2048];
+    static float floatsRead[512];
+    static int16_t shortsRead[2048];
+    for (size_t i = 0; i < 512; ++i)
+    {
+        floats[i] = i * 0.25f;
+    }
+    for (size_t i = 0; i < 2048; ++i)
+    {
+        shorts[i] = static_cast<int16_t>(i * 37 - 20000);
+    }
+
+    for (int type = 0; type < 2; ++type)
+    {
+        const char* const typeName = (type == 0) ? "float[512]" : "int16[2048]";
+        const size_t byteCount = (type == 0) ? sizeof(floats) : sizeof(shorts);
+        for (int method = 0; method < 3; ++method)
+        {
+            static const char* const methodNames[] = {"loop", "array", "array BE"};
+            FramI2CSimDevice chip(256);
+            FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+            bus.attach(chip);
+            FramI2C fram;
+            fram.begin(bus, 256);
+            const FramByteOrder byteOrder = (method == 2) ? FramByteOrder::BigEndian : FramByteOrder::Native;
+            memset(floatsRead, 0, sizeof(floatsRead));
+            memset(shortsRead, 0, sizeof(shortsRead));
+
+            for (int direction = 0; direction < 2; ++direction)
+            {
+                bus.resetStatistics();
+                FramI2C::ResultCode resultcode = FramI2C::ResultCode::Success;
+                if (type == 0)
+                {
+                    if (method == 0)
+                    {
+                        for (size_t i = 0; i < 512 && resultcode == FramI2C::ResultCode::Success; ++i)
+                        {
+                            resultcode = (direction == 0) 
+                                ? fram.write(i * sizeof(float), floats[i]) 
+                                : fram.read(i * sizeof(float), floatsRead[i]);
+                        }
+                    }
+                    else
+                    {
+                        resultcode = (direction == 0) 
+                            ? fram.writeArray(0, floats, 512, byteOrder) 
+                            : fram.readArray(0, floatsRead, 512, byteOrder);
+                    }
+                }
+                else
+                {
+                    if (method == 0)
+                    {
+                        for (size_t i = 0; i < 2048 && resultcode == FramI2C::ResultCode::Success; ++i)
+                        {
+                            resultcode = (direction == 0) 
+                                ? fram.write(i * sizeof(int16_t), shorts[i]) 
+                                : fram.read(i * sizeof(int16_t), shortsRead[i]);
+                        }
+                    }
+                    else
+                    {
+                        resultcode = (direction == 0) 
+                            ? fram.writeArray(0, shorts, 2048, byteOrder) 
+                            : fram.readArray(0, shortsRead, 2048, byteOrder);
+                    }
+                }
+                if (direction == 1)
+                {
+                    bool ok = (type == 0) 
+                        ? memcmp(floats, floatsRead, sizeof(floats)) == 0 
+                        : memcmp(shorts, shortsRead, sizeof(shorts)) == 0;
+                    resultcode = ok ? resultcode : FramI2C::ResultCode::I2CReadError;
+                }
+                char operation[48];
+                snprintf(operation, sizeof(operation), "%s %-5s %s", typeName, direction == 0 ? "write" : "read", methodNames[method]);
+                report(operation, bus, byteCount, resultcode);
+            }
+        }
+    }
+    printf("\n");
+}
+
+
+static void swapScalar(uint8_t* const data, const size_t elementSize, const size_t elementCount)
+{
+    // Reference: byte by byte reversal of every element.
+    for (size_t i = 0; i < elementCount; ++i)
+    {
+        uint8_t* element = data + i * elementSize;
+        for (size_t low = 0, high = elementSize - 1; low < high; ++low, --high)
+        {
+            uint8_t byte = element[low];
+            element[low] = element[high];
+            element[high] = byte;
+        }
+    }
+}
+
+
+static void benchmarkByteSwap(void)
+{
+    // Host CPU time to byte swap 4 MB with a byte by byte loop and with FramI2CEndian::swap()
+    // (SSSE3/NEON or word at a time, depending on the host and compiler flags).
+
+    const size_t byteCount = 4 * 1024 * 1024;
+    std::vector<uint8_t> reference(byteCount);
+    std::vector<uint8_t> data(byteCount);
+    for (size_t i = 0; i < byteCount; ++i)
+    {
+        reference[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+
+#if defined(__SSSE3__)
+    const char* const method = "SSSE3";
+#elif defined(__ARM_NEON)
+    const char* const method = "NEON";
+#elif defined(__SIZEOF_POINTER__) && __SIZEOF_POINTER__ >= 8
+    const char* const method = "64-bit word";
+#else
+    const char* const method = "scalar";
+#endif
+    printf("Byte swap (4 MB, host CPU time, FramI2CEndian::swap uses %s)\n", method);
+    static const size_t elementSizes[] = {2, 4, 8};
+    for (size_t elementSize : elementSizes)
+    {
+        const size_t elementCount = byteCount / elementSize;
+        double microseconds[2];
+        for (int wide = 0; wide < 2; ++wide)
+        {
+            data = reference;
+            auto start = std::chrono::steady_clock::now();
+            for (int repeat = 0; repeat < 10; ++repeat)
+            {
+                if (wide)
+                {
+                    FramI2CEndian::swap(data.data(), elementSize, elementCount);
+                }
+                else
+                {
+                    swapScalar(data.data(), elementSize, elementCount);
+                }
+            }
+            auto stop = std::chrono::steady_clock::now();
+            microseconds[wide] = std::chrono::duration<double, std::micro>(stop - start).count() / 10;
+        }
+        // An even number of swaps restores the original data.
+        bool ok = data == reference;
+        printf("    %zu byte elements  byte loop %8.1f us  swap() %8.1f us  %5.1fx%s\n", elementSize,
+            microseconds[0], microseconds[1], microseconds[0] / microseconds[1], ok ? "" : "  (FAILED)");
+    }
+    printf("\n");
+}
+
+
+static void benchmarkSerializer(void)
+{
+    // A record of 24 mixed fields plus an int16_t[256] array, written per field with write()
+    // and packed with FramI2CSerializer, and decoded on the host from the chip's memory image.
+
+    printf("Serializer (record of 24 fields + int16_t[256], 64 kb FRAM @ 400 kHz)\n");
+    static int16_t samples[256];
+    for (size_t i = 0; i < 256; ++i)
+    {
+        samples[i] = static_cast<int16_t>(i * 100 - 12800);
+    }
+
+    for (int packed = 0; packed < 2; ++packed)
+    {
+        FramI2CSimDevice chip(64);
+        FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+        bus.attach(chip);
+        FramI2C fram;
+        fram.begin(bus, 64);
+
+        bus.resetStatistics();
+        FramI2C::ResultCode resultcode = FramI2C::ResultCode::Success;
+        size_t byteCount = 0;
+        if (packed)
+        {
+            FramI2CSerializer serializer(fram, 0);
+            for (uint8_t i = 0; i < 8; ++i)
+            {
+                serializer.write(static_cast<uint8_t>(i));
+                serializer.write(static_cast<uint32_t>(i * 1000));
+                serializer.write(i * 0.5f);
+            }
+            serializer.writeArray(samples, 256);
+            resultcode = serializer.flush();
+            byteCount = serializer.address();
+
+            FramImageDecoder decoder(chip.memory(), fram.memorySize());
+            bool ok = true;
+            for (uint8_t i = 0; i < 8; ++i)
+            {
+                uint8_t byteField = 0;
+                uint32_t wordField = 0;
+                float floatField = 0;
+                ok = ok && decoder.read(byteField) && decoder.read(wordField) && decoder.read(floatField)
+                    && byteField == i && wordField == i * 1000u && floatField == i * 0.5f;
+            }
+            int16_t decoded[256];
+            ok = ok && decoder.readArray(decoded, 256) && memcmp(decoded, samples, sizeof(samples)) == 0;
+            resultcode = ok ? resultcode : FramI2C::ResultCode::I2CReadError;
+        }
+        else
+        {
+            uint32_t address = 0;
+            for (uint8_t i = 0; i < 8; ++i)
+            {
+                fram.write(address, i);
+                fram.write(address + 1, static_cast<uint32_t>(i * 1000));
+                fram.write(address + 5, i * 0.5f);
+                address += 9;
+            }
+            for (size_t i = 0; i < 256; ++i)
+            {
+                resultcode = fram.write(address + i * 2, samples[i]);
+            }
+            byteCount = address + sizeof(samples);
+        }
+        report(packed ? "serializer" : "write() per field", bus, byteCount, resultcode);
+    }
+    printf("\n");
+}
+
+
+static void asyncCompleted(const FramI2C::ResultCode resultcode, void* const context)
+{
+    *static_cast<FramI2C::ResultCode*>(context) = resultcode;
+}
+
+
+static void benchmarkAsync(void)
+{
+    // 64 KB write, blocking with writeBytes() and queued with FramI2CAsync.
+    // For the async write the longest bus time of a single poll() is what the caller's loop is blocked.
+
+    printf("Async (64 KB write and read back, 512 kb FRAM @ 400 kHz, 32 byte buffer)\n");
+    const size_t byteCount = 64 * 1024;
+    std::vector<uint8_t> data(byteCount);
+    std::vector<uint8_t> readBack(byteCount);
+    for (size_t i = 0; i < byteCount; ++i)
+    {
+        data[i] = static_cast<uint8_t>(i ^ (i >> 8));
+    }
+
+    FramI2CSimDevice chip(512);
+    FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+    bus.attach(chip);
+    FramI2C fram;
+    fram.begin(bus, 512);
+
+    bus.resetStatistics();
+    FramI2C::ResultCode resultcode = fram.writeBytes(0, byteCount, data.data());
+    printf("    %-28s %10.1f ms blocking\n", "writeBytes()", bus.elapsedNanos() / 1e6);
+
+    FramI2CAsync framAsync;
+    framAsync.begin(fram);
+    FramI2C::ResultCode writeResult = FramI2C::ResultCode::Uninitialized;
+    FramI2C::ResultCode readResult = FramI2C::ResultCode::Uninitialized;
+    framAsync.writeBytes(0, byteCount, data.data(), asyncCompleted, &writeResult);
+    framAsync.readBytes(0, byteCount, readBack.data(), asyncCompleted, &readResult);
+
+    bus.resetStatistics();
+    uint32_t pollCount = 0;
+    uint64_t longestPollNanos = 0;
+    while (framAsync.isBusy())
+    {
+        uint64_t before = bus.elapsedNanos();
+        framAsync.poll();
+        uint64_t pollNanos = bus.elapsedNanos() - before;
+        longestPollNanos = (pollNanos > longestPollNanos) ? pollNanos : longestPollNanos;
+        ++pollCount;
+    }
+    bool ok = resultcode == FramI2C::ResultCode::Success && writeResult == FramI2C::ResultCode::Success 
+        && readResult == FramI2C::ResultCode::Success && data == readBack;
+    printf("    %-28s %10.1f ms total, %u polls, longest poll %.3f ms%s\n", "FramI2CAsync write + read",
+        bus.elapsedNanos() / 1e6, pollCount, longestPollNanos / 1e6, ok ? "" : "  (FAILED)");
+    framAsync.end();
+    printf("\n");
+}
+
+
+static void benchmarkWriteQueue(void)
+{
+    // One loop iteration of a firmware that updates a 64 byte state record field by field
+    // (16 uint16_t fields, then 8 uint32_t counters over the second half, then 4 status bytes
+    // of which two are written twice), written directly and via FramWriteQueue.
+
+    printf("Write queue (30 small writes per iteration, 100 iterations, 64 kb FRAM @ 400 kHz)\n");
+    std::vector<uint8_t> reference;
+    for (int queued = 0; queued < 2; ++queued)
+    {
+        FramI2CSimDevice chip(64);
+        FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+        bus.attach(chip);
+        FramI2C fram;
+        fram.begin(bus, 64);
+        FramWriteQueue writeQueue;
+        writeQueue.begin(fram, 32, 256);
+
+        bus.resetStatistics();
+        for (uint16_t iteration = 0; iteration < 100; ++iteration)
+        {
+            struct Write
+            {
+                uint32_t address;
+                uint32_t value;
+                uint8_t size;
+            };
+            Write writes[30];
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < 16; ++i)
+            {
+                writes[count++] = {0x100u + i * 2u, iteration * 16u + i, 2};
+            }
+            for (uint8_t i = 0; i < 8; ++i)
+            {
+                writes[count++] = {0x120u + i * 4u, iteration * 1000u + i, 4};
+            }
+            for (uint8_t i = 0; i < 4; ++i)
+            {
+                writes[count++] = {0x140u + i, static_cast<uint32_t>(iteration + i), 1};
+            }
+            writes[count++] = {0x141, 0xAA, 1};
+            writes[count++] = {0x142, 0x55, 1};
+
+            for (uint8_t i = 0; i < count; ++i)
+            {
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&writes[i].value);
+                if (queued)
+                {
+                    writeQueue.writeBytes(writes[i].address, writes[i].size, bytes);
+                }
+                else
+                {
+                    fram.writeBytes(writes[i].address, writes[i].size, bytes);
+                }
+            }
+            if (queued)
+            {
+                writeQueue.commit();
+            }
+        }
+
+        std::vector<uint8_t> memory(chip.memory(), chip.memory() + fram.memorySize());
+        bool ok = !queued || memory == reference;
+        reference = memory;
+        printf("    %-8s %6u trans %10.0f us", queued ? "queued" : "direct", bus.transactionCount(), bus.elapsedNanos() / 1000.0);
+        if (queued)
+        {
+            printf("   (%u writes, %u superseded, %u transactions, coalescing ratio %.1f)",
+                writeQueue.statistics().requestCount, writeQueue.statistics().supersededCount, 
+                writeQueue.statistics().transactionCount, writeQueue.statistics().coalescingRatio());
+        }
+        printf("%s\n", ok ? "" : "  (FAILED)");
+        writeQueue.end();
+    }
+    printf("\n");
+}
+
+
+static void benchmarkScatterGather(void)
+{
+    // 100 records of header (8 bytes), payload (48 bytes) and CRC (4 bytes) in separate buffers,
+    // written and read with one call per buffer and with writev()/readv().
+
+    printf("Scatter-gather (100 records of 8 + 48 + 4 bytes, 64 kb FRAM @ 400 kHz)\n");
+    uint8_t header[8];
+    uint8_t payload[48];
+    uint8_t crc[4];
+    uint8_t headerRead[8];
+    uint8_t payloadRead[48];
+    uint8_t crcRead[4];
+    memset(header, 0x11, sizeof(header));
+    memset(payload, 0x22, sizeof(payload));
+    memset(crc, 0x33, sizeof(crc));
+    const size_t recordSize = sizeof(header) + sizeof(payload) + sizeof(crc);
+
+    for (int vectored = 0; vectored < 2; ++vectored)
+    {
+        FramI2CSimDevice chip(64);
+        FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+        bus.attach(chip);
+        FramI2C fram;
+        fram.begin(bus, 64);
+        const FramI2CWriteSegment writeSegments[] = {{header, sizeof(header)}, {payload, sizeof(payload)}, {crc, sizeof(crc)}};
+        const FramI2CReadSegment readSegments[] = {{headerRead, sizeof(headerRead)}, {payloadRead, sizeof(payloadRead)}, {crcRead, sizeof(crcRead)}};
+
+        for (int direction = 0; direction < 2; ++direction)
+        {
+            bus.resetStatistics();
+            FramI2C::ResultCode resultcode = FramI2C::ResultCode::Success;
+            for (uint32_t record = 0; record < 100 && resultcode == FramI2C::ResultCode::Success; ++record)
+            {
+                uint32_t address = record * recordSize;
+                if (direction == 0)
+                {
+                    if (vectored)
+                    {
+                        resultcode = fram.writev(address, writeSegments, 3);
+                    }
+                    else
+                    {
+                        resultcode = fram.writeBytes(address, sizeof(header), header);
+                        fram.writeBytes(address + sizeof(header), sizeof(payload), payload);
+                        fram.writeBytes(address + sizeof(header) + sizeof(payload), sizeof(crc), crc);
+                    }
+                }
+                else
+                {
+                    if (vectored)
+                    {
+                        resultcode = fram.readv(address, readSegments, 3);
+                    }
+                    else
+                    {
+                        resultcode = fram.readBytes(address, sizeof(headerRead), headerRead);
+                        fram.readBytes(address + sizeof(header), sizeof(payloadRead), payloadRead);
+                        fram.readBytes(address + sizeof(header) + sizeof(payload), sizeof(crcRead), crcRead);
+                    }
+                    bool ok = memcmp(header, headerRead, sizeof(header)) == 0 && memcmp(payload, payloadRead, sizeof(payload)) == 0
+                        && memcmp(crc, crcRead, sizeof(crc)) == 0;
+                    resultcode = ok ? resultcode : FramI2C::ResultCode::I2CReadError;
+                }
+            }
+            char operation[48];
+            snprintf(operation, sizeof(operation), "%s %s", direction == 0 ? "write" : "read",
+                vectored ? (direction == 0 ? "writev()" : "readv()") : "per buffer");
+            report(operation, bus, 100 * recordSize, resultcode);
+        }
+    }
+    printf("\n");
+}
+
+
+static FramI2C::ResultCode fillPerByte(FramI2CBus& bus, const FramI2C& fram, const uint8_t value)
+{
+    // Reference: the previous fill() implementation, which queued every data byte with a separate write(value).
+    const size_t chunkSize = fram.i2cBufferLength() - fram.addressBytesCount();
+    uint32_t address = 0;
+    while (address < fram.memorySize())
+    {
+        uint16_t pageAddress = address % fram.pageSize();
+        size_t byteCount = fram.pageSize() - pageAddress;
+        byteCount = (byteCount < chunkSize) ? byteCount : chunkSize;
+        bus.beginTransmission(fram.i2cAddress() + address / fram.pageSize());
+        if (fram.addressBytesCount() > 1)
+        {
+            bus.write(pageAddress >> 8);
+        }
+        bus.write(pageAddress & 0xFF);
+        for (size_t i = 0; i < byteCount; ++i)
+        {
+            bus.write(value);
+        }
+        if (bus.endTransmission(true) != FramI2CBus::TwiSuccess)
+        {
+            return FramI2C::ResultCode::I2CWriteError;
+        }
+        address += byteCount;
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+static void benchmarkFill(void)
+{
+    // Erase of a 1 Mb chip with per byte queueing (previous fill()) and with erase(), which queues every
+    // chunk with a few bulk writes from a prebuilt pattern buffer. The modeled bus time is the same,
+    // the number of bus buffer calls (each a Wire library call on an MCU) and the host CPU time are not.
+
+    printf("Fill (erase 1 Mb FRAM @ 1 MHz, 255 byte I2C buffer)\n");
+    printf("    %-28s %9s %10s %14s %12s\n", "method", "trans", "bus calls", "bus time (ms)", "host CPU (us)");
+    FramI2CSimDevice chip(1024);
+    FramI2CSimBus bus(255, FramI2CSimBus::Speed::FastModePlus);
+    bus.attach(chip);
+    FramI2C fram;
+    fram.begin(bus, 1024, 0x50, 0, 255);
+    for (int bulk = 0; bulk < 2; ++bulk)
+    {
+        const uint8_t value = bulk ? 0x5A : 0xA5;
+        bus.resetStatistics();
+        auto start = std::chrono::steady_clock::now();
+        FramI2C::ResultCode resultcode = bulk ? fram.erase(value) : fillPerByte(bus, fram, value);
+        auto stop = std::chrono::steady_clock::now();
+        bool ok = true;
+        for (size_t i = 0; i < fram.memorySize(); ++i)
+        {
+            ok = ok && chip.memory()[i] == value;
+        }
+        printf("    %-28s %9u %10u %14.1f %12.1f%s\n", bulk ? "erase()" : "per byte write(value)",
+            bus.transactionCount(), bus.bufferCallCount(), bus.elapsedNanos() / 1e6,
+            std::chrono::duration<double, std::micro>(stop - start).count(),
+            (resultcode == FramI2C::ResultCode::Success && ok) ? "" : "  (FAILED)");
+    }
+
+    // Multi-byte pattern, starting at an odd address and crossing the page boundary.
+    const uint8_t pattern[] = {0xDE, 0xAD, 0xBE, 0xEF};
+    const uint32_t address = fram.pageSize() - 1001;
+    const size_t byteCount = 4003;
+    bus.resetStatistics();
+    FramI2C::ResultCode resultcode = fram.fillPattern(address, byteCount, pattern, sizeof(pattern));
+    bool ok = true;
+    for (size_t i = 0; i < byteCount; ++i)
+    {
+        ok = ok && chip.memory()[address + i] == pattern[i % sizeof(pattern)];
+    }
+    ok = ok && chip.memory()[address - 1] == 0x5A && chip.memory()[address + byteCount] == 0x5A;
+    report("fillPattern(0xDEADBEEF)", bus, byteCount, (resultcode == FramI2C::ResultCode::Success && ok) ? resultcode : FramI2C::ResultCode::I2CWriteError);
+    printf("\n");
+}
+
+
+static void benchmarkCopy(void)
+{
+    // Copies 8 KB within a 256 kb chip (non-overlapping, and overlapping in both directions) and between
+    // two chips on separate buses. Throughput is byteCount divided by the modeled time of both buses.
+
+    printf("Copy (8 KB, 256 kb FRAM @ 400 kHz, 32 byte I2C buffer)\n");
+    const size_t byteCount = 8192;
+    FramI2CSimDevice chip(256);
+    FramI2CSimDevice chip2(256);
+    FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+    FramI2CSimBus bus2(32, FramI2CSimBus::Speed::FastMode);
+    bus.attach(chip);
+    bus2.attach(chip2);
+    FramI2C fram;
+    FramI2C fram2;
+    fram.begin(bus, 256);
+    fram2.begin(bus2, 256);
+    std::vector<uint8_t> reference(fram.memorySize());
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        reference[i] = static_cast<uint8_t>(i * 13 + 5);
+    }
+
+    struct CopyCase
+    {
+        const char* operation;
+        uint32_t sourceAddress;
+        uint32_t destinationAddress;
+        bool crossChip;
+    };
+    static const CopyCase copyCases[] =
+    {
+        {"copy() non-overlapping", 0, 16384, false},
+        {"copy() overlap, dst > src", 1000, 1100, false},
+        {"copy() overlap, dst < src", 1100, 1000, false},
+        {"copy() to other chip", 0, 16384, true}
+    };
+    for (const CopyCase& copyCase : copyCases)
+    {
+        fram.writeBytes(static_cast<uint32_t>(0), reference.size(), reference.data());
+        fram2.fill(static_cast<uint32_t>(0), fram2.memorySize(), 0);
+        bus.resetStatistics();
+        bus2.resetStatistics();
+        FramI2C::ResultCode resultcode = copyCase.crossChip
+            ? FramI2C::copy(fram, copyCase.sourceAddress, fram2, copyCase.destinationAddress, byteCount)
+            : fram.copy(copyCase.sourceAddress, copyCase.destinationAddress, byteCount);
+
+        std::vector<uint8_t> expected = reference;
+        const uint8_t* memory = chip.memory();
+        if (copyCase.crossChip)
+        {
+            expected.assign(fram2.memorySize(), 0);
+            memory = chip2.memory();
+        }
+        memmove(expected.data() + copyCase.destinationAddress, reference.data() + copyCase.sourceAddress, byteCount);
+        bool ok = memcmp(expected.data(), memory, expected.size()) == 0;
+
+        // Report the combined bus time of both buses (they are not used concurrently).
+        uint64_t nanos = bus.elapsedNanos() + bus2.elapsedNanos();
+        uint32_t transactions = bus.transactionCount() + bus2.transactionCount();
+        double kiloBytesPerSecond = (nanos > 0) ? byteCount * 1e6 / nanos : 0.0;
+        printf("    %-28s %7zu B %6u trans %12.1f us %9.1f kB/s%s\n", copyCase.operation, byteCount, transactions,
+            nanos / 1000.0, kiloBytesPerSecond, (resultcode == FramI2C::ResultCode::Success && ok) ? "" : "  (FAILED)");
+    }
+    printf("\n");
+}
+
+
+static void benchmarkVerify(void)
+{
+    // Writes a 4 KB block and verifies it by reading it back into a second full-size buffer, with compare()
+    // (no extra buffer) and with write verify enabled (every chunk is read back right after it is written).
+
+    printf("Verify (4 KB write + verify, 64 kb FRAM @ 400 kHz)\n");
+    const size_t byteCount = 4096;
+    FramI2CSimDevice chip(64);
+    FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+    bus.attach(chip);
+    FramI2C fram;
+    fram.begin(bus, 64);
+    std::vector<uint8_t> data(byteCount);
+    for (size_t i = 0; i < byteCount; ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 11 + 1);
+    }
+
+    for (int method = 0; method < 3; ++method)
+    {
+        fram.setWriteVerify(method == 2);
+        bus.resetStatistics();
+        FramI2C::ResultCode resultcode = fram.writeBytes(static_cast<uint32_t>(0), byteCount, data.data());
+        if (method == 0 && resultcode == FramI2C::ResultCode::Success)
+        {
+            std::vector<uint8_t> readBack(byteCount);
+            resultcode = fram.readBytes(static_cast<uint32_t>(0), byteCount, readBack.data());
+            resultcode = (readBack == data) ? resultcode : FramI2C::ResultCode::VerifyError;
+        }
+        else if (method == 1 && resultcode == FramI2C::ResultCode::Success)
+        {
+            size_t mismatchOffset;
+            resultcode = fram.compare(static_cast<uint32_t>(0), byteCount, data.data(), mismatchOffset);
+        }
+        static const char* const operations[] = {"write + read back + memcmp", "write + compare()", "write with setWriteVerify()"};
+        report(operations[method], bus, byteCount, resultcode);
+    }
+
+    // A write protected chip acknowledges the data but does not store it, write verify detects this.
+    chip.setWriteProtected(true);
+    FramI2C::ResultCode resultcode = fram.writeBytes(static_cast<uint32_t>(0), 16, data.data() + 1);
+    printf("    write protected chip: %s\n", resultcode == FramI2C::ResultCode::VerifyError ? "VerifyError" : "not detected  (FAILED)");
+    fram.setWriteVerify(false);
+    printf("\n");
+}
+
+
+static void benchmarkChecksum(void)
+{
+    // CRC-32 of a 32 KB parameter store: read into RAM in 128 byte blocks and computed in application code,
+    // and with checksum() which feeds the chunks from the I2C buffer into the CRC engine.
+    // Followed by the host CPU throughput of the CRC engines.
+
+    printf("Checksum (32 KB, 256 kb FRAM @ 400 kHz, 32 byte I2C buffer)\n");
+    FramI2CSimDevice chip(256);
+    FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+    bus.attach(chip);
+    FramI2C fram;
+    fram.begin(bus, 256);
+    for (size_t i = 0; i < fram.memorySize(); ++i)
+    {
+        chip.memory()[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    const uint32_t expected = FramI2CCrc::compute(FramCrcAlgorithm::Crc32, chip.memory(), fram.memorySize());
+
+    for (int streamed = 0; streamed < 2; ++streamed)
+    {
+        bus.resetStatistics();
+        FramI2C::ResultCode resultcode = FramI2C::ResultCode::Success;
+        uint32_t crc = 0;
+        if (streamed)
+        {
+            resultcode = fram.checksum(static_cast<uint32_t>(0), fram.memorySize(), FramCrcAlgorithm::Crc32, crc);
+        }
+        else
+        {
+            uint8_t block[128];
+            FramI2CCrc crcEngine(FramCrcAlgorithm::Crc32);
+            for (uint32_t address = 0; address < fram.memorySize() && resultcode == FramI2C::ResultCode::Success; address += sizeof(block))
+            {
+                resultcode = fram.readBytes(address, sizeof(block), block);
+                crcEngine.update(block, sizeof(block));
+            }
+            crc = crcEngine.value();
+        }
+        resultcode = (crc == expected) ? resultcode : FramI2C::ResultCode::I2CReadError;
+        report(streamed ? "checksum()" : "read 128 B blocks + CRC", bus, fram.memorySize(), resultcode);
+    }
+
+    const size_t byteCount = 4 * 1024 * 1024;
+    std::vector<uint8_t> data(byteCount);
+    for (size_t i = 0; i < byteCount; ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    static const FramCrcAlgorithm algorithms[] = {FramCrcAlgorithm::Crc16Ccitt, FramCrcAlgorithm::Crc32, FramCrcAlgorithm::Crc32C};
+    for (FramCrcAlgorithm algorithm : algorithms)
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint32_t crc = FramI2CCrc::compute(algorithm, data.data(), byteCount);
+        auto stop = std::chrono::steady_clock::now();
+        double microseconds = std::chrono::duration<double, std::micro>(stop - start).count();
+        printf("    %-20s %-8s 4 MB host CPU %9.1f us %8.1f MB/s  (0x%08X)\n", FramI2CCrc::algorithmName(algorithm),
+            FramI2CCrc::isHardwareAccelerated(algorithm) ? "hardware" : "table", microseconds, byteCount / microseconds, crc);
+    }
+    printf("\n");
+}
+
+
+template<typename Fram> static FramI2C::ResultCode fixedAccess(Fram& fram, const int iterations)
+{
+    // Writes and reads back a value at constant addresses on both pages of a 1 Mb chip.
+    FramI2C::ResultCode resultcode = FramI2C::ResultCode::Success;
+    for (int i = 0; i < iterations && resultcode == FramI2C::ResultCode::Success; ++i)
+    {
+        uint32_t value = static_cast<uint32_t>(i);
+        uint32_t readBack = 0;
+        resultcode = fram.write(static_cast<uint32_t>(0x0100), value);
+        resultcode = (resultcode == FramI2C::ResultCode::Success) ? fram.read(static_cast<uint32_t>(0x10100), readBack) : resultcode;
+        resultcode = (resultcode == FramI2C::ResultCode::Success) ? fram.write(static_cast<uint32_t>(0x10100), value) : resultcode;
+        resultcode = (resultcode == FramI2C::ResultCode::Success) ? fram.read(static_cast<uint32_t>(0x0100), readBack) : resultcode;
+        resultcode = (readBack == value) ? resultcode : FramI2C::ResultCode::I2CReadError;
+    }
+    return resultcode;
+}
+
+
+static void benchmarkFixed(void)
+{
+    // Small transfers at constant addresses with FramI2C (range checks and page split at run time)
+    // and FramI2CFixed<1024> (checks and page selection evaluated at compile time).
+    // The I2C transactions are identical, only the host CPU time per call differs.
+
+    printf("Fixed geometry (4 B write/read at constant addresses, 1 Mb FRAM @ 1 MHz)\n");
+    printf("    %-28s %9s %14s %16s\n", "class", "trans", "bus time (ms)", "host CPU (ns/call)");
+    const int iterations = 20000;
+    for (int fixed = 0; fixed < 2; ++fixed)
+    {
+        FramI2CSimDevice chip(1024);
+        FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastModePlus);
+        bus.attach(chip);
+        FramI2C fram;
+        FramI2CFixed<1024> framFixed;
+        fram.begin(bus, 1024);
+        framFixed.begin(bus);
+        auto start = std::chrono::steady_clock::now();
+        FramI2C::ResultCode resultcode = fixed ? fixedAccess(framFixed, iterations) : fixedAccess(fram, iterations);
+        auto stop = std::chrono::steady_clock::now();
+        printf("    %-28s %9u %14.1f %16.1f%s\n", fixed ? "FramI2CFixed<1024>" : "FramI2C",
+            bus.transactionCount(), bus.elapsedNanos() / 1e6,
+            std::chrono::duration<double, std::nano>(stop - start).count() / (iterations * 4),
+            resultcode == FramI2C::ResultCode::Success ? "" : "  (FAILED)");
+    }
+    printf("\n");
+}
+
+
+static void benchmarkDensityDetection(void)
+{
+    // begin() with AutoDetectDensity for all densities, for chips with and without device ID.
+    // Chips without device ID are probed, the memory contents must be unchanged afterwards.
+
+    printf("Density detection (begin() with AutoDetectDensity @ 400 kHz)\n");
+    printf("    %-8s %-10s %9s %8s %14s\n", "density", "device ID", "detected", "trans", "bus time (us)");
+    for (uint16_t density : Densities)
+    {
+        for (int withId = 1; withId >= 0; --withId)
+        {
+            const uint32_t deviceId = withId ? exampleDeviceId(density) : 0;
+            if ((withId && deviceId == 0) || (!withId && density == 1024))
+            {
+                // 1 Mb chips (2 pages with 16-bit addressing) always support the device ID.
+                continue;
+            }
+            FramI2CSimDevice chip(density, 0x50, deviceId);
+            FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+            bus.attach(chip);
+            for (size_t i = 0; i < chip.memorySize(); ++i)
+            {
+                chip.memory()[i] = static_cast<uint8_t>((i >> 8) ^ 0x3C);   // Equal bytes at all probed addresses.
+            }
+            std::vector<uint8_t> before(chip.memory(), chip.memory() + chip.memorySize());
+            FramI2C fram;
+            FramI2C::ResultCode resultcode = fram.begin(bus, FramI2C::AutoDetectDensity);
+            bool ok = resultcode == FramI2C::ResultCode::Success && fram.density() == density &&
+                fram.isDeviceIdSupported() == (deviceId != 0) &&
+                memcmp(before.data(), chip.memory(), chip.memorySize()) == 0;
+            printf("    %-8u %-10s %9u %8u %14.1f%s\n", density, withId ? "yes" : "no", fram.density(),
+                bus.transactionCount(), bus.elapsedNanos() / 1000.0, ok ? "" : "  (FAILED)");
+        }
+    }
+
+    // Configurations that cannot be determined without device ID must return DensityDetectionError
+    // (and leave memory unchanged) instead of a wrong density.
+    static const struct
+    {
+        const char* name;
+        uint16_t density;
+        uint8_t chipCount;
+        bool writeProtected;
+    } undetectable[] =
+    {
+        {"no chip", 64, 0, false},
+        {"2 x 64 kb on 0x50/0x51", 64, 2, false},
+        {"2 x 256 kb on 0x50/0x51", 256, 2, false},
+        {"1 Mb without device ID", 1024, 1, false},
+        {"64 kb write protected", 64, 1, true},
+        {"256 kb write protected", 256, 1, true},
+        {"16 kb write protected", 16, 1, true}
+    };
+    for (const auto& configuration : undetectable)
+    {
+        FramI2CSimDevice chip0(configuration.density, 0x50);
+        FramI2CSimDevice chip1(configuration.density, 0x51);
+        FramI2CSimDevice* chips[] = {&chip0, &chip1};
+        FramI2CSimBus bus(32, FramI2CSimBus::Speed::FastMode);
+        std::vector<uint8_t> before;
+        for (uint8_t c = 0; c < configuration.chipCount; ++c)
+        {
+            bus.attach(*chips[c]);
+            chips[c]->setWriteProtected(configuration.writeProtected);
+            for (size_t i = 0; i < chips[c]->memorySize(); ++i)
+            {
+                chips[c]->memory()[i] = static_cast<uint8_t>((i >> 8) ^ 0x3C ^ c);
+            }
+            before.insert(before.end(), chips[c]->memory(), chips[c]->memory() + chips[c]->memorySize());
+        }
+        FramI2C fram;
+        FramI2C::ResultCode resultcode = fram.begin(bus, FramI2C::AutoDetectDensity);
+        std::vector<uint8_t> after;
+        for (uint8_t c = 0; c < configuration.chipCount; ++c)
+        {
+            after.insert(after.end(), chips[c]->memory(), chips[c]->memory() + chips[c]->memorySize());
+        }
+        bool ok = resultcode == FramI2C::ResultCode::DensityDetectionError && after == before;
+        printf("    %-30s %s%s\n", configuration.name,
+            (resultcode == FramI2C::ResultCode::DensityDetectionError) ? "DensityDetectionError" : "detected",
+            ok ? "" : "  (FAILED)");
+    }
+    printf("\n");
+}
+
+
+static void benchmarkMirror(void)
+{
+    // Two mirrored chips, each on its own bus. Chip 1 is disconnected (does not acknowledge its I2C address)
+    // during writes: it becomes degraded, the written regions are marked dirty for it and reads are served
+    // by chip 0. After reconnecting, resync() copies only the dirty regions to chip 1.
+
+    printf("Mirror (2 x 64 kb FRAM @ 400 kHz, 128 byte I2C buffer)\n");
+    FramI2CSimDevice chip0(64);
+    FramI2CSimDevice chip1(64);
+    FramI2CSimBus bus0(128, FramI2CSimBus::Speed::FastMode);
+    FramI2CSimBus bus1(128, FramI2CSimBus::Speed::FastMode);
+    bus0.attach(chip0);
+    bus1.attach(chip1);
+    for (size_t i = 0; i < chip0.memorySize(); ++i)
+    {
+        chip0.memory()[i] = static_cast<uint8_t>(i * 7 + 3);
+        chip1.memory()[i] = chip0.memory()[i];
+    }
+    FramI2C fram0;
+    FramI2C fram1;
+    fram0.begin(bus0, 64);
+    fram1.begin(bus1, 64);
+    FramMirror mirror;
+    mirror.begin(fram0, fram1);
+
+    // Writes touching regions 7-8, 39 and 54-57 while chip 1 is disconnected.
+    chip1.setConnected(false);
+    std::vector<uint8_t> data(100);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>(i + 0x40);
+    }
+    const uint8_t expectedDirtyRegions = 7;
+    FramI2C::ResultCode resultcode = mirror.writeBytes(static_cast<uint32_t>(1000), 100, data.data());
+    if (resultcode == FramI2C::ResultCode::Success)
+    {
+        resultcode = mirror.writeBytes(static_cast<uint32_t>(5000), 20, data.data());
+    }
+    if (resultcode == FramI2C::ResultCode::Success)
+    {
+        resultcode = mirror.fill(static_cast<uint32_t>(7000), 300, 0xA5);
+    }
+    bool ok = resultcode == FramI2C::ResultCode::Success && mirror.isDegraded(1) && !mirror.isDegraded(0)
+        && mirror.dirtyRegionCount(1) == expectedDirtyRegions && mirror.dirtyRegionCount(0) == 0;
+    printf("    write, chip 1 disconnected:  chip 1 degraded, %u dirty regions%s\n",
+        mirror.dirtyRegionCount(1), ok ? "" : "  (FAILED)");
+
+    // Reads alternate between the chips, but chip 1 is degraded: all reads go to chip 0.
+    bus0.resetStatistics();
+    bus1.resetStatistics();
+    ok = true;
+    std::vector<uint8_t> readBack(512);
+    for (uint32_t address = 0; address < 8192; address += 512)
+    {
+        ok = ok && mirror.readBytes(address, readBack.size(), readBack.data()) == FramI2C::ResultCode::Success
+            && memcmp(readBack.data(), chip0.memory() + address, readBack.size()) == 0;
+    }
+    ok = ok && bus0.transactionCount() > 0 && bus1.transactionCount() == 0;
+    printf("    read while degraded:         %u trans on chip 0, %u on chip 1%s\n",
+        bus0.transactionCount(), bus1.transactionCount(), ok ? "" : "  (FAILED)");
+
+    // Resync after reconnecting: a probe (address write + 1 byte read) and one write per 32 byte copy piece
+    // of every dirty region; a full copy would write all regions.
+    chip1.setConnected(true);
+    bus1.resetStatistics();
+    resultcode = mirror.resync();
+    const uint32_t piecesPerRegion = mirror.regionSize() / 32;
+    const uint32_t expectedTransactions = 2 + expectedDirtyRegions * piecesPerRegion;
+    ok = resultcode == FramI2C::ResultCode::Success && !mirror.isDegraded(1) && mirror.dirtyRegionCount(1) == 0
+        && memcmp(chip0.memory(), chip1.memory(), chip0.memorySize()) == 0
+        && bus1.transactionCount() == expectedTransactions;
+    printf("    resync, chip 1 reconnected:  %u trans (full copy %u), images %s%s\n",
+        bus1.transactionCount(), 2 + FramMirror::RegionCount * piecesPerRegion,
+        memcmp(chip0.memory(), chip1.memory(), chip0.memorySize()) == 0 ? "identical" : "differ",
+        ok ? "" : "  (FAILED)");
+    printf("\n");
+}
+
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-t") == 0)
+        {
+            trace = stdout;
+        }
+    }
+
+    benchmarkOperations();
+    benchmarkChunkSize();
+    benchmarkStreamingRead();
+    benchmarkStripe();
+    benchmarkWriteCache();
+    benchmarkReadCache();
+    benchmarkArray();
+    benchmarkByteSwap();
+    benchmarkSerializer();
+    benchmarkAsync();
+    benchmarkWriteQueue();
+    benchmarkScatterGather();
+    benchmarkFill();
+    benchmarkCopy();
+    benchmarkVerify();
+    benchmarkChecksum();
+    benchmarkFixed();
+    benchmarkDensityDetection();
+    benchmarkMirror();
+    return 0;
+}
@@ -0,0 +1,419 @@
+/* FramI2CSimBus.cpp
+ *
+ * Description:  In-memory FRAM simulator for building and running FramI2C on a (Linux) host.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include <string.h>
+#include "FramI2CSimBus.h"
+#include "FramI2CGeometry.h"
+
+
+// --- FramI2CSimDevice -------------------------------------------------------
+
+FramI2CSimDevice::FramI2CSimDevice(const uint16_t densityInKiloBits, const uint8_t i2cAddress, const uint32_t deviceId)
+    : density_(densityInKiloBits), i2cAddress_(i2cAddress), deviceId_(deviceId)
+{
+    if (!FramI2CGeometry::isDensitySupported(densityInKiloBits))
+    {
+        // Chip without memory, does not respond.
+        pageSize_ = 0;
+        addressBytesCount_ = 0;
+        return;
+    }
+
+    // Same geometry as FramI2C (FramI2CGeometry.h).
+    size_t memorySize = FramI2CGeometry::memorySize(densityInKiloBits);
+    pageSize_ = FramI2CGeometry::pageSize(densityInKiloBits);
+    addressBytesCount_ = FramI2CGeometry::addressBytesCount(densityInKiloBits);
+    memory_.assign(memorySize, 0);
+}
+
+
+uint16_t FramI2CSimDevice::density(void) const
+{
+    return density_;
+}
+
+
+uint8_t FramI2CSimDevice::i2cAddress(void) const
+{
+    return i2cAddress_;
+}
+
+
+size_t FramI2CSimDevice::memorySize(void) const
+{
+    return memory_.size();
+}
+
+
+size_t FramI2CSimDevice::pageSize(void) const
+{
+    return pageSize_;
+}
+
+
+uint8_t FramI2CSimDevice::pageCount(void) const
+{
+    return (pageSize_ == 0) ? 0 : memory_.size() / pageSize_;
+}
+
+
+uint8_t FramI2CSimDevice::addressBytesCount(void) const
+{
+    return addressBytesCount_;
+}
+
+
+uint32_t FramI2CSimDevice::deviceId(void) const
+{
+    return deviceId_;
+}
+
+
+uint8_t* FramI2CSimDevice::memory(void)
+{
+    return memory_.data();
+}
+
+
+const uint8_t* FramI2CSimDevice::memory(void) const
+{
+    return memory_.data();
+}
+
+
+bool FramI2CSimDevice::isWriteProtected(void) const
+{
+    return writeProtected_;
+}
+
+
+void FramI2CSimDevice::setWriteProtected(const bool enabled)
+{
+    writeProtected_ = enabled;
+}
+
+
+bool FramI2CSimDevice::isConnected(void) const
+{
+    return connected_;
+}
+
+
+void FramI2CSimDevice::setConnected(const bool connected)
+{
+    connected_ = connected;
+}
+
+
+bool FramI2CSimDevice::respondsTo(const uint8_t i2cAddress) const
+{
+    return connected_ && !memory_.empty() && i2cAddress >= i2cAddress_ && i2cAddress < i2cAddress_ + pageCount();
+}
+
+
+void FramI2CSimDevice::write(const uint8_t i2cAddress, const uint8_t* const data, const size_t byteCount)
+{
+    if (byteCount < addressBytesCount_)
+    {
+        // Incomplete address, the address latch is not changed.
+        return;
+    }
+
+    uint32_t page = i2cAddress - i2cAddress_;
+    uint32_t address = data[0];
+    if (addressBytesCount_ > 1)
+    {
+        address = (address << 8) | data[1];
+    }
+    addressLatch_ = (page * pageSize_ + address) % memory_.size();
+
+    for (size_t i = addressBytesCount_; i < byteCount; ++i)
+    {
+        if (!writeProtected_)
+        {
+            memory_[addressLatch_] = data[i];
+        }
+        addressLatch_ = (addressLatch_ + 1) % memory_.size();
+    }
+}
+
+
+void FramI2CSimDevice::read(uint8_t* const data, const size_t byteCount)
+{
+    for (size_t i = 0; i < byteCount; ++i)
+    {
+        data[i] = memory_[addressLatch_];
+        addressLatch_ = (addressLatch_ + 1) % memory_.size();
+    }
+}
+
+
+// --- FramI2CSimBus ----------------------------------------------------------
+
+FramI2CSimBus::FramI2CSimBus(const size_t bufferLength, const Speed speed) : bufferLength_(bufferLength)
+{
+    setSpeed(speed);
+}
+
+
+void FramI2CSimBus::attach(FramI2CSimDevice& device)
+{
+    devices_.push_back(&device);
+}
+
+
+size_t FramI2CSimBus::bufferLength(void) const
+{
+    return bufferLength_;
+}
+
+
+FramI2CSimBus::Speed FramI2CSimBus::speed(void) const
+{
+    return speed_;
+}
+
+
+void FramI2CSimBus::setSpeed(const Speed speed)
+{
+    // Timing values are the minimum values from the I2C-bus specification (NXP UM10204).
+    // START = tSU;STA + tHD;STA, STOP = tSU;STO + tBUF.
+    // In high speed mode each transfer that starts on an idle bus is preceded by a fast mode
+    // START and master code (8 bits + NACK). Bus free time after STOP is the fast mode tBUF.
+    speed_ = speed;
+    switch (speed)
+    {
+        case Speed::StandardMode:
+            timing_ = {10000, 4700 + 4000, 4000 + 4700, 0};
+            break;
+        case Speed::FastMode:
+            timing_ = {2500, 600 + 600, 600 + 1300, 0};
+            break;
+        case Speed::FastModePlus:
+            timing_ = {1000, 260 + 260, 260 + 500, 0};
+            break;
+        case Speed::HighSpeedMode:
+            timing_ = {294, 160 + 160, 160 + 1300, 600 + 600 + 9 * 2500};
+            break;
+    }
+}
+
+
+const char* FramI2CSimBus::speedName(const Speed speed)
+{
+    switch (speed)
+    {
+        case Speed::StandardMode:
+            return "100 kHz";
+        case Speed::FastMode:
+            return "400 kHz";
+        case Speed::FastModePlus:
+            return "1 MHz";
+        case Speed::HighSpeedMode:
+            return "3.4 MHz";
+    }
+    return "";
+}
+
+
+uint64_t FramI2CSimBus::elapsedNanos(void) const
+{
+    return elapsedNanos_;
+}
+
+
+uint32_t FramI2CSimBus::transactionCount(void) const
+{
+    return transactionCount_;
+}
+
+
+uint32_t FramI2CSimBus::bufferCallCount(void) const
+{
+    return bufferCallCount_;
+}
+
+
+void FramI2CSimBus::resetStatistics(void)
+{
+    elapsedNanos_ = 0;
+    transactionCount_ = 0;
+    bufferCallCount_ = 0;
+}
+
+
+void FramI2CSimBus::setTrace(FILE* const trace)
+{
+    trace_ = trace;
+}
+
+
+void FramI2CSimBus::beginTransmission(const uint8_t i2cAddress)
+{
+    txAddress_ = i2cAddress;
+    txBuffer_.clear();
+}
+
+
+size_t FramI2CSimBus::write(const uint8_t value)
+{
+    ++bufferCallCount_;
+    if (txBuffer_.size() >= bufferLength_)
+    {
+        return 0;
+    }
+    txBuffer_.push_back(value);
+    return 1;
+}
+
+
+size_t FramI2CSimBus::write(const uint8_t* const data, const size_t byteCount)
+{
+    ++bufferCallCount_;
+    size_t available = bufferLength_ - txBuffer_.size();
+    size_t bytesQueued = (byteCount > available) ? available : byteCount;
+    txBuffer_.insert(txBuffer_.end(), data, data + bytesQueued);
+    return bytesQueued;
+}
+
+
+uint8_t FramI2CSimBus::endTransmission(const bool sendStop)
+{
+    if (txAddress_ == DeviceIdAddress)
+    {
+        // Device ID read: the single data byte is the (shifted) I2C address of the chip.
+        // The 3 byte device ID is subsequently read with requestFrom(DeviceIdAddress, 3).
+        deviceIdDevice_ = nullptr;
+        if (txBuffer_.size() == 1)
+        {
+            FramI2CSimDevice* device = findDevice(txBuffer_[0] >> 1);
+            if (device != nullptr && device->deviceId() != 0)
+            {
+                deviceIdDevice_ = device;
+            }
+        }
+        addTransaction("id-write", txAddress_, txBuffer_.size(), deviceIdDevice_ != nullptr, sendStop);
+        txBuffer_.clear();
+        return (deviceIdDevice_ != nullptr) ? FramI2CBus::TwiSuccess : FramI2CBus::TwiDataNack;
+    }
+
+    FramI2CSimDevice* device = findDevice(txAddress_);
+    addTransaction("write", txAddress_, txBuffer_.size(), device != nullptr, sendStop);
+    if (device == nullptr)
+    {
+        txBuffer_.clear();
+        return FramI2CBus::TwiAddressNack;
+    }
+    device->write(txAddress_, txBuffer_.data(), txBuffer_.size());
+    txBuffer_.clear();
+    return FramI2CBus::TwiSuccess;
+}
+
+
+size_t FramI2CSimBus::requestFrom(const uint8_t i2cAddress, const size_t byteCount, const bool sendStop)
+{
+    rxBuffer_.clear();
+    rxIndex_ = 0;
+    size_t bytesRead = (byteCount > bufferLength_) ? bufferLength_ : byteCount;
+
+    if (i2cAddress == DeviceIdAddress)
+    {
+        FramI2CSimDevice* device = deviceIdDevice_;
+        deviceIdDevice_ = nullptr;
+        addTransaction("id-read", i2cAddress, (device != nullptr) ? bytesRead : 0, device != nullptr, sendStop);
+        if (device == nullptr)
+        {
+            return 0;
+        }
+        for (size_t i = 0; i < bytesRead; ++i)
+        {
+            // Device ID is returned MSB first, bytes after the device ID read as 0xFF.
+            rxBuffer_.push_back((i < DeviceIdSize) ? (device->deviceId() >> (8 * (DeviceIdSize - 1 - i))) & 0xFF : 0xFF);
+        }
+        return bytesRead;
+    }
+
+    FramI2CSimDevice* device = findDevice(i2cAddress);
+    addTransaction("read", i2cAddress, (device != nullptr) ? bytesRead : 0, device != nullptr, sendStop);
+    if (device == nullptr)
+    {
+        return 0;
+    }
+    rxBuffer_.resize(bytesRead);
+    device->read(rxBuffer_.data(), bytesRead);
+    return bytesRead;
+}
+
+
+int FramI2CSimBus::read(void)
+{
+    ++bufferCallCount_;
+    if (rxIndex_ >= rxBuffer_.size())
+    {
+        return -1;
+    }
+    return rxBuffer_[rxIndex_++];
+}
+
+
+size_t FramI2CSimBus::readBytes(uint8_t* const data, const size_t byteCount)
+{
+    ++bufferCallCount_;
+    size_t available = rxBuffer_.size() - rxIndex_;
+    size_t bytesRead = (byteCount > available) ? available : byteCount;
+    memcpy(data, rxBuffer_.data() + rxIndex_, bytesRead);
+    rxIndex_ += bytesRead;
+    return bytesRead;
+}
+
+
+void FramI2CSimBus::addTransaction(const char* const type, const uint8_t i2cAddress, const size_t byteCount, const bool ack, const bool sendStop)
+{
+    // Models the duration of a single transaction:
+    // [master code] START, address byte + ACK, byteCount * (data byte + ACK), [STOP].
+    // If the address is not acknowledged the transaction ends after the address byte.
+
+    uint64_t nanos = 0;
+    if (!busHeld_)
+    {
+        nanos += timing_.masterCode;
+    }
+    nanos += timing_.start;
+    nanos += static_cast<uint64_t>(1 + (ack ? byteCount : 0)) * 9 * timing_.clockPeriod;
+    if (sendStop || !ack)
+    {
+        nanos += timing_.stop;
+    }
+    busHeld_ = !sendStop && ack;
+
+    elapsedNanos_ += nanos;
+    ++transactionCount_;
+
+    if (trace_ != nullptr)
+    {
+        fprintf(trace_, "%-8s 0x%02X %4zu bytes %s%s %8.2f us\n",
+            type, i2cAddress, byteCount, ack ? "ack " : "nack", sendStop ? " stop" : "     ", nanos / 1000.0);
+    }
+}
+
+
+FramI2CSimDevice* FramI2CSimBus::findDevice(const uint8_t i2cAddress) const
+{
+    for (FramI2CSimDevice* device : devices_)
+    {
+        if (device->respondsTo(i2cAddress))
+        {
+            return device;
+        }
+    }
+    return nullptr;
+}
+
+
+/* eof */
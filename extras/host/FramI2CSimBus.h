@@ -0,0 +1,166 @@
+/* FramI2CSimBus.h
+ *
+ * Description:  In-memory FRAM simulator for building and running FramI2C on a (Linux) host.
+ *               FramI2CSimDevice simulates a single FRAM chip, FramI2CSimBus simulates the I2C bus
+ *               (with Wire compatible buffer behavior) to which one or more simulated chips are attached.
+ *
+ *               FramI2CSimBus models the time that each I2C transaction takes on a real bus
+ *               (START, address byte, data bytes, ACK and STOP) for standard mode (100 kHz),
+ *               fast mode (400 kHz), fast mode plus (1 MHz) and high speed mode (3.4 MHz).
+ *               The modeled time is accumulated and can be used to benchmark FramI2C operations.
+ *
+ *               Example usage:
+ *                 FramI2CSimDevice chip(64);       // 64 kb FRAM on I2C address 0x50
+ *                 FramI2CSimBus bus;
+ *                 bus.attach(chip);
+ *                 FramI2C fram;
+ *                 fram.begin(bus, 64);
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CSIMBUS_H_
+#define FRAMI2CSIMBUS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "FramI2CBus.h"
+
+
+class FramI2CSimDevice
+{
+
+public:
+
+    // densityInKiloBits must be one of the densities supported by FramI2C (4, 16, 64, 128, 256, 512 or 1024),
+    // for other values the simulated chip does not respond.
+    // deviceId is the 3 byte device ID (manufacturer ID in bits 23-12, product ID in bits 11-0)
+    // returned via reserved I2C address 0x7C. 0 means that the chip does not support a device ID.
+    explicit FramI2CSimDevice(const uint16_t densityInKiloBits, const uint8_t i2cAddress = 0x50, const uint32_t deviceId = 0);
+
+    uint16_t density(void) const;
+    uint8_t i2cAddress(void) const;
+    size_t memorySize(void) const;
+    size_t pageSize(void) const;
+    uint8_t pageCount(void) const;
+    uint8_t addressBytesCount(void) const;
+    uint32_t deviceId(void) const;
+
+    // Direct (non I2C) access to the simulated memory, e.g. for preloading or checking contents.
+    uint8_t* memory(void);
+    const uint8_t* memory(void) const;
+
+    // Simulates the write protect (WP) pin: while enabled, data bytes are acknowledged but not written.
+    bool isWriteProtected(void) const;
+    void setWriteProtected(const bool enabled);
+
+    // Simulates a disconnected (or unpowered) chip: while disconnected the chip does not
+    // acknowledge its I2C addresses. Memory contents are kept.
+    bool isConnected(void) const;
+    void setConnected(const bool connected);
+
+    // Returns true if i2cAddress is one of the (page) I2C addresses of the chip and the chip is connected.
+    bool respondsTo(const uint8_t i2cAddress) const;
+
+    // Handles a write transaction. The first addressBytesCount() bytes set the address latch,
+    // remaining bytes are written to memory. The address latch auto-increments and
+    // rolls over at the end of memory, like a real FRAM chip.
+    void write(const uint8_t i2cAddress, const uint8_t* const data, const size_t byteCount);
+
+    // Handles a (current address) read transaction.
+    void read(uint8_t* const data, const size_t byteCount);
+
+private:
+
+    uint16_t density_;
+    uint8_t i2cAddress_;
+    size_t pageSize_;
+    uint8_t addressBytesCount_;
+    uint32_t deviceId_;
+    uint32_t addressLatch_ = 0;
+    bool writeProtected_ = false;
+    bool connected_ = true;
+    std::vector<uint8_t> memory_;
+};
+
+
+class FramI2CSimBus : public FramI2CBus
+{
+
+public:
+
+    enum class Speed : uint8_t
+    {
+        StandardMode,       // 100 kHz
+        FastMode,           // 400 kHz
+        FastModePlus,       // 1 MHz
+        HighSpeedMode       // 3.4 MHz
+    };
+
+    // Default buffer length is the same as for the AVR Wire library.
+    explicit FramI2CSimBus(const size_t bufferLength = 32, const Speed speed = Speed::FastMode);
+
+    void attach(FramI2CSimDevice& device);
+
+    size_t bufferLength(void) const override;
+    Speed speed(void) const;
+    void setSpeed(const Speed speed);
+    static const char* speedName(const Speed speed);
+
+    // Modeled bus time and transaction count since the last call to resetStatistics().
+    uint64_t elapsedNanos(void) const;
+    uint32_t transactionCount(void) const;
+    // Number of calls to write() and read()/readBytes() since the last call to resetStatistics().
+    // Not part of the modeled bus time, but on an MCU every call is a separate Wire library call.
+    uint32_t bufferCallCount(void) const;
+    void resetStatistics(void);
+
+    // If trace is not null, every transaction and its modeled time is printed to trace.
+    void setTrace(FILE* const trace);
+
+    void beginTransmission(const uint8_t i2cAddress) override;
+    size_t write(const uint8_t value) override;
+    size_t write(const uint8_t* const data, const size_t byteCount) override;
+    uint8_t endTransmission(const bool sendStop) override;
+    size_t requestFrom(const uint8_t i2cAddress, const size_t byteCount, const bool sendStop) override;
+    int read(void) override;
+    size_t readBytes(uint8_t* const data, const size_t byteCount) override;
+
+private:
+
+    // Reserved I2C address used for reading the device ID.
+    static const uint8_t DeviceIdAddress = 0x7C;
+    static const size_t DeviceIdSize = 3;
+
+    struct Timing
+    {
+        uint32_t clockPeriod;       // ns per SCL clock period.
+        uint32_t start;             // ns for (repeated) START condition.
+        uint32_t stop;              // ns for STOP condition including bus free time.
+        uint32_t masterCode;        // ns for (fast mode) START and master code before high speed transfer.
+    };
+
+    FramI2CSimDevice* findDevice(const uint8_t i2cAddress) const;
+    void addTransaction(const char* const type, const uint8_t i2cAddress, const size_t byteCount, const bool ack, const bool sendStop);
+
+    size_t bufferLength_;
+    Speed speed_;
+    Timing timing_;
+    bool busHeld_ = false;
+    uint64_t elapsedNanos_ = 0;
+    uint32_t transactionCount_ = 0;
+    uint32_t bufferCallCount_ = 0;
+    FILE* trace_ = nullptr;
+    FramI2CSimDevice* deviceIdDevice_ = nullptr;
+    uint8_t txAddress_ = 0;
+    std::vector<uint8_t> txBuffer_;
+    std::vector<uint8_t> rxBuffer_;
+    size_t rxIndex_ = 0;
+    std::vector<FramI2CSimDevice*> devices_;
+};
+
+#endif  //FRAMI2CSIMBUS_H_
@@ -0,0 +1,43 @@
+/* FramImageDecoder.cpp
+ *
+ * Description:  Host side decoder for FRAM images containing data written with FramI2CSerializer.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramImageDecoder.h"
+
+
+FramImageDecoder::FramImageDecoder(const uint8_t* const image, const size_t imageSize, const uint32_t address)
+    : image_(image), imageSize_(image != nullptr ? imageSize : 0), address_(address)
+{
+    // Empty.
+}
+
+
+size_t FramImageDecoder::imageSize(void) const
+{
+    return imageSize_;
+}
+
+
+uint32_t FramImageDecoder::address(void) const
+{
+    return address_;
+}
+
+
+bool FramImageDecoder::seek(const uint32_t address)
+{
+    if (address > imageSize_)
+    {
+        return false;
+    }
+    address_ = address;
+    return true;
+}
+
+
+/* eof */
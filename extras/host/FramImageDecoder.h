@@ -0,0 +1,72 @@
+/* FramImageDecoder.h
+ *
+ * Description:  Host side decoder for FRAM images (e.g. a memory dump or the memory of a
+ *               FramI2CSimDevice) containing data written with FramI2CSerializer.
+ *               Values are decoded from the portable packed format (see FramI2CPacked.h), independent
+ *               of the platform that wrote them. The image is not copied and must remain valid.
+ *
+ *               Example usage:
+ *                 FramImageDecoder decoder(image, imageSize, 0x100);
+ *                 uint16_t version;
+ *                 float temperature;
+ *                 int16_t samples[64];
+ *                 bool ok = decoder.read(version) && decoder.read(temperature) && decoder.readArray(samples, 64);
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMIMAGEDECODER_H_
+#define FRAMIMAGEDECODER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FramI2CPacked.h"
+
+
+class FramImageDecoder
+{
+
+public:
+
+    FramImageDecoder(const uint8_t* const image, const size_t imageSize, const uint32_t address = 0);
+
+    size_t imageSize(void) const;
+
+    // Address of the next value.
+    uint32_t address(void) const;
+
+    // Returns false if address is beyond the end of the image.
+    bool seek(const uint32_t address);
+
+
+    template<typename T> bool read(T& value)
+    {
+        return readArray(&value, 1);
+    }
+
+
+    template<typename T> bool readArray(T* const values, const size_t count)
+    {
+        // Decodes count values. Returns false (and values is unchanged) if the image ends before the last value.
+
+        const size_t size = FramPackedType<T>::size;
+        if (values == nullptr || address_ > imageSize_ || count > (imageSize_ - address_) / size)
+        {
+            return false;
+        }
+        FramI2CPacked::decode(image_ + address_, count, values);
+        address_ += count * size;
+        return true;
+    }
+
+
+private:
+
+    const uint8_t* image_;
+    size_t imageSize_;
+    uint32_t address_;
+};
+
+#endif  //FRAMIMAGEDECODER_H_
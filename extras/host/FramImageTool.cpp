@@ -0,0 +1,643 @@
+/* FramImageTool.cpp
+ *
+ * Description:  Linux host tool for offline analysis of FRAM images, e.g. images collected from
+ *               a fleet of devices with FramImageTransfer. Images are raw binary files (one byte per
+ *               FRAM byte) and are memory-mapped, not read, so large image collections are processed
+ *               without copying. Addresses are linear (as used by FramI2C), the page layout is that of
+ *               FramI2C (FramI2CGeometry.h): where a density has multiple pages, addresses are also
+ *               shown as page:page address.
+ *
+ *               Usage: FramImageTool info <image>...
+ *                      FramImageTool hexdump <image> [-a address] [-n count] [-v]
+ *                      FramImageTool diff <reference> <image>...
+ *                      FramImageTool search <pattern> <image>... [-s] [-m max]
+ *                      FramImageTool decode <format> <image>... [-a address]
+ *                 -d <density>   Density in kilobits (default: derived from the image size).
+ *                 -a <address>   Start address (default 0).
+ *                 -n <count>     Number of bytes (default: up to the end of the image).
+ *                 -v             Hexdump: show identical consecutive rows (default: shown as '*').
+ *                 -s             Search: pattern is text instead of hex bytes (e.g. DEADBEEF).
+ *                 -m <max>       Search: maximum number of matches reported per image (default 100).
+ *
+ *               decode reads values written with FramI2CSerializer (portable packed format, see
+ *               FramImageDecoder.h) and prints one line per image. format is a comma separated list
+ *               of types with an optional element count: bool, u8, i8, u16, i16, u32, i32, u64, i64,
+ *               f32, f64, e.g. "u16,f32,i16[8]".
+ *
+ *               Build (from the repository root):
+ *                 g++ -std=c++11 -O2 -Isrc -Iextras/host src/FramI2CCrc.cpp extras/host/FramImageDecoder.cpp
+ *                     extras/host/FramImageTool.cpp -o FramImageTool
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#define _GNU_SOURCE 1     // memmem()
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "FramI2CCrc.h"
+#include "FramI2CGeometry.h"
+#include "FramImageDecoder.h"
+
+
+static const char HexDigits[] = "0123456789ABCDEF";
+
+
+class MappedImage
+{
+    // Read-only memory mapping of an image file.
+
+public:
+
+    MappedImage(void) = default;
+    MappedImage(const MappedImage&) = delete;
+    MappedImage& operator=(const MappedImage&) = delete;
+
+    ~MappedImage(void)
+    {
+        if (data_ != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(data_), size_);
+        }
+    }
+
+    bool open(const char* const path)
+    {
+        path_ = path;
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        struct stat status;
+        bool ok = fstat(fd, &status) == 0;
+        if (ok && status.st_size > 0)
+        {
+            size_ = static_cast<size_t>(status.st_size);
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = data != MAP_FAILED;
+            if (ok)
+            {
+                data_ = static_cast<const uint8_t*>(data);
+                madvise(data, size_, MADV_SEQUENTIAL);
+            }
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Cannot map %s: %s\n", path, strerror(errno));
+        }
+        close(fd);
+        return ok;
+    }
+
+    const char* path(void) const { return path_; }
+    const uint8_t* data(void) const { return data_; }
+    size_t size(void) const { return size_; }
+
+private:
+
+    const char* path_ = "";
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+
+struct Options
+{
+    uint16_t density = 0;
+    uint32_t address = 0;
+    size_t byteCount = SIZE_MAX;
+    bool verbose = false;
+    bool text = false;
+    size_t maxMatches = 100;
+    std::vector<const char*> arguments;     // Non-option arguments after the command.
+};
+
+
+static uint16_t imageDensity(const Options& options, const MappedImage& image)
+{
+    // Density given with -d, otherwise the density whose memory size equals the image size.
+    // Returns 0 (no page layout) if the image size matches no density.
+    return (options.density != 0) ? options.density : FramI2CGeometry::memorySizeToDensity(image.size());
+}
+
+
+static const char* formatAddress(const uint16_t density, const uint32_t address)
+{
+    // "0x1A2B3" or, for densities with multiple pages, "0x1A2B3 (1:A2B3)".
+    static char text[32];
+    uint32_t pageSize = FramI2CGeometry::pageSize(density);
+    if (FramI2CGeometry::pageCount(density) > 1)
+    {
+        snprintf(text, sizeof(text), "0x%05" PRIX32 " (%" PRIu32 ":%04" PRIX32 ")",
+            address, address / pageSize, address % pageSize);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "0x%05" PRIX32, address);
+    }
+    return text;
+}
+
+
+static bool mapImages(const std::vector<const char*>& paths, std::vector<MappedImage>& images)
+{
+    images = std::vector<MappedImage>(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!images[i].open(paths[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static int info(const Options& options)
+{
+    std::vector<MappedImage> images;
+    if (!mapImages(options.arguments, images))
+    {
+        return 1;
+    }
+    for (const MappedImage& image : images)
+    {
+        uint16_t density = imageDensity(options, image);
+        printf("%s: %zu bytes", image.path(), image.size());
+        if (density != 0)
+        {
+            printf(", %u kb, %u page(s) of 0x%" PRIX32 " bytes, %u address byte(s)", density,
+                FramI2CGeometry::pageCount(density), FramI2CGeometry::pageSize(density),
+                FramI2CGeometry::addressBytesCount(density));
+        }
+        printf(", CRC-32 0x%08" PRIX32 "\n", FramI2CCrc::compute(FramCrcAlgorithm::Crc32, image.data(), image.size()));
+    }
+    return 0;
+}
+
+
+static int hexdump(const Options& options)
+{
+    // Row layout as hexdumpFram() (FramI2CTools.h) with ASCII column, rows are labeled with the
+    // page address and every page starts with a page label. Output is formatted into a buffer
+    // with a lookup table and written in large blocks.
+
+    MappedImage image;
+    if (!image.open(options.arguments[0]))
+    {
+        return 1;
+    }
+    if (options.address >= image.size())
+    {
+        fprintf(stderr, "Address 0x%" PRIX32 " is beyond the end of the image.\n", options.address);
+        return 1;
+    }
+    const uint16_t density = imageDensity(options, image);
+    // Images without page layout are labeled with the linear address.
+    const uint32_t pageSize = (density != 0) ? FramI2CGeometry::pageSize(density) : 0;
+    const int labelShift = (density != 0) ? 12 : 28;
+    const size_t available = image.size() - options.address;
+    const uint32_t endAddress = options.address + ((options.byteCount < available) ? options.byteCount : available);
+    const uint8_t* const data = image.data();
+
+    std::vector<char> output;
+    output.reserve(1 << 20);
+    char line[9 + 16 * 3 + 2 + 3 + 16 + 1 + 1];
+    bool repeated = false;
+    uint32_t rowAddress = options.address & ~0xFu;
+
+    while (rowAddress < endAddress)
+    {
+        uint32_t pageAddress = (pageSize != 0) ? rowAddress % pageSize : rowAddress;
+        if ((pageSize != 0 && pageAddress == 0) || rowAddress == (options.address & ~0xFu))
+        {
+            if (density != 0 && FramI2CGeometry::pageCount(density) > 1)
+            {
+                char label[48];
+                int length = snprintf(label, sizeof(label), "page %" PRIu32 " (linear address 0x%05" PRIX32 "):\n",
+                    rowAddress / pageSize, rowAddress - pageAddress);
+                output.insert(output.end(), label, label + length);
+            }
+            repeated = false;
+        }
+
+        // Identical complete rows after the first are shown as a single '*'.
+        bool complete = rowAddress >= options.address && rowAddress + 16 <= endAddress
+            && (pageSize == 0 || pageAddress != 0) && rowAddress != (options.address & ~0xFu);
+        if (!options.verbose && complete && memcmp(data + rowAddress, data + rowAddress - 16, 16) == 0)
+        {
+            if (!repeated)
+            {
+                output.push_back('*');
+                output.push_back('\n');
+                repeated = true;
+            }
+            rowAddress += 16;
+            continue;
+        }
+        repeated = false;
+
+        size_t length = 0;
+        for (int shift = labelShift; shift >= 0; shift -= 4)
+        {
+            line[length++] = HexDigits[(pageAddress >> shift) & 0xF];
+        }
+        line[length++] = ':';
+        for (uint8_t column = 0; column < 16; ++column)
+        {
+            uint32_t byteAddress = rowAddress + column;
+            bool present = byteAddress >= options.address && byteAddress < endAddress;
+            if (column == 8)
+            {
+                line[length++] = ' ';
+                line[length++] = present ? '-' : ' ';
+            }
+            line[length++] = ' ';
+            line[length++] = present ? HexDigits[data[byteAddress] >> 4] : ' ';
+            line[length++] = present ? HexDigits[data[byteAddress] & 0xF] : ' ';
+        }
+        line[length++] = ' ';
+        line[length++] = ' ';
+        line[length++] = '|';
+        for (uint8_t column = 0; column < 16; ++column)
+        {
+            uint32_t byteAddress = rowAddress + column;
+            uint8_t value = (byteAddress >= options.address && byteAddress < endAddress) ? data[byteAddress] : ' ';
+            line[length++] = (value >= 0x20 && value < 0x7F) ? static_cast<char>(value) : '.';
+        }
+        line[length++] = '|';
+        line[length++] = '\n';
+        output.insert(output.end(), line, line + length);
+
+        if (output.size() >= (1 << 20) - 256)
+        {
+            fwrite(output.data(), 1, output.size(), stdout);
+            output.clear();
+        }
+        rowAddress += 16;
+    }
+    fwrite(output.data(), 1, output.size(), stdout);
+    return 0;
+}
+
+
+static int diff(const Options& options)
+{
+    // Prints the ranges in which each image differs from the reference image.
+    // Equal blocks are skipped with memcmp, only differing blocks are compared byte by byte.
+    // Returns 1 if any image differs.
+
+    if (options.arguments.size() < 2)
+    {
+        fprintf(stderr, "diff requires a reference image and at least one image.\n");
+        return 2;
+    }
+    std::vector<MappedImage> images;
+    if (!mapImages(options.arguments, images))
+    {
+        return 2;
+    }
+    const MappedImage& reference = images[0];
+    const uint16_t density = imageDensity(options, reference);
+    const size_t blockSize = 4096;
+    int result = 0;
+
+    for (size_t i = 1; i < images.size(); ++i)
+    {
+        const MappedImage& image = images[i];
+        const size_t size = (image.size() < reference.size()) ? image.size() : reference.size();
+        size_t rangeCount = 0;
+        size_t differingBytes = 0;
+        bool inRange = false;
+        size_t rangeStart = 0;
+
+        for (size_t block = 0; block < size; block += blockSize)
+        {
+            size_t blockEnd = (block + blockSize < size) ? block + blockSize : size;
+            if (!inRange && memcmp(reference.data() + block, image.data() + block, blockEnd - block) == 0)
+            {
+                continue;
+            }
+            for (size_t address = block; address < blockEnd; ++address)
+            {
+                bool differs = reference.data()[address] != image.data()[address];
+                if (differs && !inRange)
+                {
+                    rangeStart = address;
+                    inRange = true;
+                }
+                else if (!differs && inRange)
+                {
+                    printf("%s: %s, %zu byte(s)\n", image.path(), formatAddress(density, rangeStart), address - rangeStart);
+                    differingBytes += address - rangeStart;
+                    ++rangeCount;
+                    inRange = false;
+                }
+            }
+        }
+        if (inRange)
+        {
+            printf("%s: %s, %zu byte(s)\n", image.path(), formatAddress(density, rangeStart), size - rangeStart);
+            differingBytes += size - rangeStart;
+            ++rangeCount;
+        }
+        if (image.size() != reference.size())
+        {
+            printf("%s: size %zu differs from reference size %zu\n", image.path(), image.size(), reference.size());
+        }
+        if (rangeCount != 0 || image.size() != reference.size())
+        {
+            printf("%s: %zu byte(s) differ in %zu range(s)\n", image.path(), differingBytes, rangeCount);
+            result = 1;
+        }
+    }
+    return result;
+}
+
+
+static bool parseHexPattern(const char* text, std::vector<uint8_t>& pattern)
+{
+    // Hex bytes, optionally separated by spaces, e.g. "DEADBEEF" or "DE AD BE EF".
+    pattern.clear();
+    int high = -1;
+    for (; *text != '\0'; ++text)
+    {
+        if (*text == ' ')
+        {
+            continue;
+        }
+        const char* digit = strchr(HexDigits, toupper(static_cast<unsigned char>(*text)));
+        if (digit == nullptr)
+        {
+            return false;
+        }
+        int value = static_cast<int>(digit - HexDigits);
+        if (high < 0)
+        {
+            high = value;
+        }
+        else
+        {
+            pattern.push_back(static_cast<uint8_t>((high << 4) | value));
+            high = -1;
+        }
+    }
+    return high < 0 && !pattern.empty();
+}
+
+
+static int search(const Options& options)
+{
+    // Prints the addresses of all occurrences (up to -m per image) of the pattern.
+    // Returns 1 if the pattern is not found in any image.
+
+    if (options.arguments.size() < 2)
+    {
+        fprintf(stderr, "search requires a pattern and at least one image.\n");
+        return 2;
+    }
+    std::vector<uint8_t> pattern;
+    if (options.text)
+    {
+        pattern.assign(options.arguments[0], options.arguments[0] + strlen(options.arguments[0]));
+    }
+    if ((options.text && pattern.empty()) || (!options.text && !parseHexPattern(options.arguments[0], pattern)))
+    {
+        fprintf(stderr, "Invalid pattern: %s\n", options.arguments[0]);
+        return 2;
+    }
+    std::vector<MappedImage> images;
+    if (!mapImages(std::vector<const char*>(options.arguments.begin() + 1, options.arguments.end()), images))
+    {
+        return 2;
+    }
+
+    int result = 1;
+    for (const MappedImage& image : images)
+    {
+        const uint16_t density = imageDensity(options, image);
+        const uint8_t* const end = image.data() + image.size();
+        const uint8_t* position = image.data() + ((options.address < image.size()) ? options.address : image.size());
+        size_t matchCount = 0;
+        while (matchCount < options.maxMatches && static_cast<size_t>(end - position) >= pattern.size())
+        {
+            const void* match = memmem(position, end - position, pattern.data(), pattern.size());
+            if (match == nullptr)
+            {
+                break;
+            }
+            position = static_cast<const uint8_t*>(match);
+            printf("%s: %s\n", image.path(), formatAddress(density, position - image.data()));
+            ++matchCount;
+            ++position;
+        }
+        result = (matchCount != 0) ? 0 : result;
+    }
+    return result;
+}
+
+
+struct DecodeField
+{
+    std::string type;
+    size_t count;
+};
+
+
+template<typename T> static bool decodeValues(FramImageDecoder& decoder, const size_t count, const char* const format)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        T value;
+        if (!decoder.read(value))
+        {
+            return false;
+        }
+        printf(format, value);
+    }
+    return true;
+}
+
+
+static bool decodeField(FramImageDecoder& decoder, const DecodeField& field)
+{
+    // Decodes and prints count values of the field's type, each preceded by a space.
+    const std::string& type = field.type;
+    const size_t count = field.count;
+    if (type == "bool")
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            bool value;
+            if (!decoder.read(value))
+            {
+                return false;
+            }
+            printf(" %s", value ? "true" : "false");
+        }
+        return true;
+    }
+    if (type == "u8") return decodeValues<uint8_t>(decoder, count, " %" PRIu8);
+    if (type == "i8") return decodeValues<int8_t>(decoder, count, " %" PRId8);
+    if (type == "u16") return decodeValues<uint16_t>(decoder, count, " %" PRIu16);
+    if (type == "i16") return decodeValues<int16_t>(decoder, count, " %" PRId16);
+    if (type == "u32") return decodeValues<uint32_t>(decoder, count, " %" PRIu32);
+    if (type == "i32") return decodeValues<int32_t>(decoder, count, " %" PRId32);
+    if (type == "u64") return decodeValues<uint64_t>(decoder, count, " %" PRIu64);
+    if (type == "i64") return decodeValues<int64_t>(decoder, count, " %" PRId64);
+    if (type == "f32") return decodeValues<float>(decoder, count, " %g");
+    if (type == "f64") return decodeValues<double>(decoder, count, " %g");
+    return false;
+}
+
+
+static bool parseFormat(const char* const format, std::vector<DecodeField>& fields)
+{
+    static const char* const types[] = {"bool", "u8", "i8", "u16", "i16", "u32", "i32", "u64", "i64", "f32", "f64"};
+
+    std::string text(format);
+    size_t start = 0;
+    while (start <= text.size())
+    {
+        size_t end = text.find(',', start);
+        end = (end == std::string::npos) ? text.size() : end;
+        std::string item = text.substr(start, end - start);
+        DecodeField field = {item, 1};
+        size_t bracket = item.find('[');
+        if (bracket != std::string::npos)
+        {
+            char* countEnd = nullptr;
+            field.type = item.substr(0, bracket);
+            field.count = strtoul(item.c_str() + bracket + 1, &countEnd, 0);
+            if (field.count == 0 || strcmp(countEnd, "]") != 0)
+            {
+                return false;
+            }
+        }
+        bool known = false;
+        for (const char* type : types)
+        {
+            known = known || field.type == type;
+        }
+        if (!known)
+        {
+            return false;
+        }
+        fields.push_back(field);
+        start = end + 1;
+    }
+    return !fields.empty();
+}
+
+
+static int decode(const Options& options)
+{
+    // Prints "<image>:" followed by the decoded values, one line per image.
+    // Images that end before the last value are reported as truncated, result is then 1.
+
+    std::vector<DecodeField> fields;
+    if (options.arguments.size() < 2 || !parseFormat(options.arguments[0], fields))
+    {
+        fprintf(stderr, "decode requires a valid format and at least one image.\n");
+        return 2;
+    }
+    std::vector<MappedImage> images;
+    if (!mapImages(std::vector<const char*>(options.arguments.begin() + 1, options.arguments.end()), images))
+    {
+        return 2;
+    }
+
+    int result = 0;
+    for (const MappedImage& image : images)
+    {
+        FramImageDecoder decoder(image.data(), image.size(), options.address);
+        printf("%s:", image.path());
+        bool ok = true;
+        for (size_t i = 0; ok && i < fields.size(); ++i)
+        {
+            ok = decodeField(decoder, fields[i]);
+        }
+        printf("%s\n", ok ? "" : " (truncated)");
+        result = ok ? result : 1;
+    }
+    return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+    static const char* const usage =
+        "Usage: %s info <image>...\n"
+        "       %s hexdump <image> [-a address] [-n count] [-v]\n"
+        "       %s diff <reference> <image>...\n"
+        "       %s search <pattern> <image>... [-s] [-m max]\n"
+        "       %s decode <format> <image>... [-a address]\n"
+        "Options: -d <density>  density in kilobits (default: derived from the image size)\n";
+
+    Options options;
+    for (int i = 2; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-d") == 0 && hasValue)
+        {
+            options.density = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 0));
+            if (!FramI2CGeometry::isDensitySupported(options.density))
+            {
+                fprintf(stderr, "Unsupported density: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "-a") == 0 && hasValue)
+        {
+            options.address = strtoul(argv[++i], nullptr, 0);
+        }
+        else if (strcmp(argv[i], "-n") == 0 && hasValue)
+        {
+            options.byteCount = strtoul(argv[++i], nullptr, 0);
+        }
+        else if (strcmp(argv[i], "-m") == 0 && hasValue)
+        {
+            options.maxMatches = strtoul(argv[++i], nullptr, 0);
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            options.verbose = true;
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            options.text = true;
+        }
+        else
+        {
+            options.arguments.push_back(argv[i]);
+        }
+    }
+
+    const char* command = (argc > 1) ? argv[1] : "";
+    if (!options.arguments.empty())
+    {
+        if (strcmp(command, "info") == 0) return info(options);
+        if (strcmp(command, "hexdump") == 0) return hexdump(options);
+        if (strcmp(command, "diff") == 0) return diff(options);
+        if (strcmp(command, "search") == 0) return search(options);
+        if (strcmp(command, "decode") == 0) return decode(options);
+    }
+    fprintf(stderr, usage, argv[0], argv[0], argv[0], argv[0], argv[0]);
+    return 2;
+}
+
+/* eof */
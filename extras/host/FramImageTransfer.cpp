@@ -0,0 +1,423 @@
+/* FramImageTransfer.cpp
+ *
+ * Description:  Linux host tool for transferring FRAM images to and from a device over a serial port.
+ *               Counterpart of dumpBinary() and restoreBinary() in FramI2CTools.h, the frame format
+ *               is described in FramI2CTransfer.h. Images are raw binary files (one byte per FRAM byte).
+ *
+ *               Usage: FramImageTransfer dump <port> <file> [options]
+ *                      FramImageTransfer restore <port> <file> [options]
+ *                 -b <baud>      Baud rate (default 115200).
+ *                 -a <address>   Start address for restore (default 0). Dump uses the device's range.
+ *                 -c <command>   String sent (followed by '\n') after opening the port, e.g. to
+ *                                tell the sketch to call dumpBinary() or restoreBinary().
+ *                 -t <seconds>   Timeout while waiting for the device (default 5).
+ *
+ *               Build (from the repository root):
+ *                 g++ -std=c++11 -O2 -Isrc src/FramI2CCrc.cpp extras/host/FramImageTransfer.cpp -o FramImageTransfer
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#include "FramI2CCrc.h"
+#include "FramI2CTransfer.h"
+
+
+static int timeoutMillis = 5000;
+
+
+static speed_t baudToSpeed(const long baud)
+{
+    switch (baud)
+    {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 500000:  return B500000;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default:      return B0;
+    }
+}
+
+
+static int openPort(const char* const path, const long baud)
+{
+    // Opens the serial port in raw 8N1 mode without flow control.
+
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct termios tty;
+    if (tcgetattr(fd, &tty) != 0)
+    {
+        fprintf(stderr, "%s is not a serial port: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~CSTOPB;
+    tty.c_cflag &= ~CRTSCTS;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    speed_t speed = baudToSpeed(baud);
+    if (speed == B0)
+    {
+        fprintf(stderr, "Unsupported baud rate %ld\n", baud);
+        close(fd);
+        return -1;
+    }
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    if (tcsetattr(fd, TCSANOW, &tty) != 0)
+    {
+        fprintf(stderr, "Cannot configure %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+
+static bool readExact(const int fd, uint8_t* const data, const size_t byteCount)
+{
+    // Reads byteCount bytes, waiting at most timeoutMillis for each part.
+    size_t bytesRead = 0;
+    while (bytesRead < byteCount)
+    {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, timeoutMillis);
+        if (ready <= 0)
+        {
+            return false;
+        }
+        ssize_t n = read(fd, data + bytesRead, byteCount - bytesRead);
+        if (n < 0 && errno != EINTR && errno != EAGAIN)
+        {
+            return false;
+        }
+        bytesRead += (n > 0) ? n : 0;
+    }
+    return true;
+}
+
+
+static bool writeAll(const int fd, const uint8_t* const data, const size_t byteCount)
+{
+    size_t bytesWritten = 0;
+    while (bytesWritten < byteCount)
+    {
+        ssize_t n = write(fd, data + bytesWritten, byteCount - bytesWritten);
+        if (n < 0 && errno != EINTR && errno != EAGAIN)
+        {
+            return false;
+        }
+        bytesWritten += (n > 0) ? n : 0;
+    }
+    return true;
+}
+
+
+static bool waitForMagic(const int fd)
+{
+    // Skips everything the device sends before the magic bytes (e.g. boot messages).
+    uint32_t magic = 0;
+    while (magic != FramI2CTransfer::Magic)
+    {
+        uint8_t value;
+        if (!readExact(fd, &value, 1))
+        {
+            return false;
+        }
+        magic = (magic >> 8) | (static_cast<uint32_t>(value) << 24);
+    }
+    return true;
+}
+
+
+static bool readFrame(const int fd, std::vector<uint8_t>& frame, uint16_t& length)
+{
+    // Reads a complete frame into frame. Returns false on timeout, oversized payload or CRC error.
+    frame.resize(FramI2CTransfer::FrameHeaderSize);
+    if (!readExact(fd, frame.data(), FramI2CTransfer::FrameHeaderSize))
+    {
+        fprintf(stderr, "Timeout while waiting for frame\n");
+        return false;
+    }
+    length = FramI2CTransfer::decode16(frame.data() + 5);
+    if (length > FramI2CTransfer::MaxBlockSize)
+    {
+        fprintf(stderr, "Invalid frame length %u\n", length);
+        return false;
+    }
+    frame.resize(FramI2CTransfer::FrameHeaderSize + length + FramI2CTransfer::FrameCrcSize);
+    if (!readExact(fd, frame.data() + FramI2CTransfer::FrameHeaderSize, length + FramI2CTransfer::FrameCrcSize))
+    {
+        fprintf(stderr, "Timeout while receiving frame\n");
+        return false;
+    }
+    const uint8_t* payload = frame.data() + FramI2CTransfer::FrameHeaderSize;
+    if (FramI2CTransfer::decode32(payload + length) != FramI2CTransfer::frameCrc(frame.data(), payload, length))
+    {
+        fprintf(stderr, "CRC error in frame '%c' at address 0x%X\n", frame[0], FramI2CTransfer::decode32(frame.data() + 1));
+        return false;
+    }
+    return true;
+}
+
+
+static std::vector<uint8_t> buildFrame(const uint8_t type, const uint32_t address, const uint8_t* const payload, const uint16_t length)
+{
+    std::vector<uint8_t> frame(FramI2CTransfer::FrameHeaderSize + length + FramI2CTransfer::FrameCrcSize);
+    FramI2CTransfer::encodeFrameHeader(frame.data(), type, address, length);
+    memcpy(frame.data() + FramI2CTransfer::FrameHeaderSize, payload, length);
+    FramI2CTransfer::encode32(frame.data() + FramI2CTransfer::FrameHeaderSize + length,
+        FramI2CTransfer::frameCrc(frame.data(), payload, length));
+    return frame;
+}
+
+
+static int dump(const int fd, const char* const path)
+{
+    if (!waitForMagic(fd))
+    {
+        fprintf(stderr, "No response from device\n");
+        return 1;
+    }
+    std::vector<uint8_t> frame;
+    uint16_t length;
+    if (!readFrame(fd, frame, length) || frame[0] != FramI2CTransfer::HeaderFrame || length != FramI2CTransfer::HeaderPayloadSize)
+    {
+        fprintf(stderr, "Invalid header frame\n");
+        return 1;
+    }
+    const uint32_t address = FramI2CTransfer::decode32(frame.data() + 1);
+    const uint32_t byteCount = FramI2CTransfer::decode32(frame.data() + FramI2CTransfer::FrameHeaderSize);
+    fprintf(stderr, "Receiving 0x%X (%u) bytes from address 0x%X\n", byteCount, byteCount, address);
+
+    std::vector<uint8_t> image(byteCount);
+    uint32_t bytesReceived = 0;
+    FramI2CCrc crc(FramCrcAlgorithm::Crc32);
+    while (true)
+    {
+        if (!readFrame(fd, frame, length))
+        {
+            return 1;
+        }
+        const uint32_t frameAddress = FramI2CTransfer::decode32(frame.data() + 1);
+        const uint8_t* payload = frame.data() + FramI2CTransfer::FrameHeaderSize;
+        if (frame[0] == FramI2CTransfer::DataFrame)
+        {
+            if (frameAddress != address + bytesReceived || length > byteCount - bytesReceived)
+            {
+                fprintf(stderr, "Unexpected data frame at address 0x%X\n", frameAddress);
+                return 1;
+            }
+            memcpy(image.data() + bytesReceived, payload, length);
+            crc.update(payload, length);
+            bytesReceived += length;
+            fprintf(stderr, "\r%u%%", static_cast<unsigned>(100ull * bytesReceived / (byteCount > 0 ? byteCount : 1)));
+        }
+        else if (frame[0] == FramI2CTransfer::EndFrame && length == FramI2CTransfer::EndPayloadSize)
+        {
+            fprintf(stderr, "\n");
+            if (bytesReceived != byteCount || FramI2CTransfer::decode32(payload) != crc.value())
+            {
+                fprintf(stderr, "Image incomplete or CRC mismatch\n");
+                return 1;
+            }
+            break;
+        }
+        else
+        {
+            fprintf(stderr, "Unexpected frame '%c'\n", frame[0]);
+            return 1;
+        }
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr || fwrite(image.data(), 1, image.size(), file) != image.size())
+    {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        if (file != nullptr)
+        {
+            fclose(file);
+        }
+        return 1;
+    }
+    fclose(file);
+    fprintf(stderr, "Image written to %s, CRC-32 0x%08X\n", path, crc.value());
+    return 0;
+}
+
+
+static uint8_t readReply(const int fd, const char* const what)
+{
+    // Returns the device's reply (Ack, Nak or Cancel), 0 on timeout. Prints the reason for Cancel.
+    uint8_t reply;
+    if (!readExact(fd, &reply, 1))
+    {
+        fprintf(stderr, "Timeout while waiting for reply to %s\n", what);
+        return 0;
+    }
+    if (reply == FramI2CTransfer::Cancel)
+    {
+        uint8_t resultcode = 0;
+        readExact(fd, &resultcode, 1);
+        fprintf(stderr, "Device cancelled transfer at %s (ResultCode 0x%02X)\n", what, resultcode);
+    }
+    return reply;
+}
+
+
+static bool sendFrame(const int fd, const std::vector<uint8_t>& frame, const char* const what)
+{
+    // Sends frame and waits for Ack. A frame that is not acknowledged (Nak) is sent again, max 3 times.
+    for (int attempt = 0; attempt < 4; ++attempt)
+    {
+        if (!writeAll(fd, frame.data(), frame.size()))
+        {
+            fprintf(stderr, "Write error: %s\n", strerror(errno));
+            return false;
+        }
+        uint8_t reply = readReply(fd, what);
+        if (reply != FramI2CTransfer::Nak)
+        {
+            return reply == FramI2CTransfer::Ack;
+        }
+    }
+    fprintf(stderr, "%s not acknowledged\n", what);
+    return false;
+}
+
+
+static int restore(const int fd, const char* const path, const uint32_t address)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    std::vector<uint8_t> image;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        image.insert(image.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    const uint32_t byteCount = image.size();
+    fprintf(stderr, "Sending 0x%X (%u) bytes to address 0x%X\n", byteCount, byteCount, address);
+
+    // Magic and header, the device replies with its block size.
+    uint8_t headerPayload[FramI2CTransfer::HeaderPayloadSize];
+    FramI2CTransfer::encode32(headerPayload, byteCount);
+    FramI2CTransfer::encode16(headerPayload + 4, 0);
+    std::vector<uint8_t> header(FramI2CTransfer::MagicSize);
+    FramI2CTransfer::encode32(header.data(), FramI2CTransfer::Magic);
+    std::vector<uint8_t> headerFrame = buildFrame(FramI2CTransfer::HeaderFrame, address, headerPayload, sizeof(headerPayload));
+    header.insert(header.end(), headerFrame.begin(), headerFrame.end());
+    if (!writeAll(fd, header.data(), header.size()) || readReply(fd, "header") != FramI2CTransfer::Ack)
+    {
+        return 1;
+    }
+    uint8_t blockSizeBytes[2];
+    if (!readExact(fd, blockSizeBytes, sizeof(blockSizeBytes)))
+    {
+        fprintf(stderr, "Timeout while waiting for block size\n");
+        return 1;
+    }
+    const size_t blockSize = FramI2CTransfer::decode16(blockSizeBytes);
+    if (blockSize == 0 || blockSize > FramI2CTransfer::MaxBlockSize)
+    {
+        fprintf(stderr, "Invalid block size %zu\n", blockSize);
+        return 1;
+    }
+
+    for (uint32_t offset = 0; offset < byteCount; offset += blockSize)
+    {
+        uint16_t length = (byteCount - offset < blockSize) ? byteCount - offset : blockSize;
+        if (!sendFrame(fd, buildFrame(FramI2CTransfer::DataFrame, address + offset, image.data() + offset, length), "data frame"))
+        {
+            return 1;
+        }
+        fprintf(stderr, "\r%u%%", static_cast<unsigned>(100ull * (offset + length) / byteCount));
+    }
+    fprintf(stderr, "\n");
+
+    uint8_t endPayload[FramI2CTransfer::EndPayloadSize];
+    FramI2CTransfer::encode32(endPayload, FramI2CCrc::compute(FramCrcAlgorithm::Crc32, image.data(), image.size()));
+    if (!sendFrame(fd, buildFrame(FramI2CTransfer::EndFrame, address, endPayload, sizeof(endPayload)), "end frame"))
+    {
+        return 1;
+    }
+    fprintf(stderr, "Image restored and verified\n");
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4 || (strcmp(argv[1], "dump") != 0 && strcmp(argv[1], "restore") != 0))
+    {
+        fprintf(stderr, "Usage: %s dump|restore <port> <file> [-b baud] [-a address] [-c command] [-t seconds]\n", argv[0]);
+        return 2;
+    }
+    long baud = 115200;
+    uint32_t address = 0;
+    const char* command = nullptr;
+    for (int i = 4; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-b") == 0)
+        {
+            baud = strtol(argv[i + 1], nullptr, 0);
+        }
+        else if (strcmp(argv[i], "-a") == 0)
+        {
+            address = strtoul(argv[i + 1], nullptr, 0);
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            command = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+        {
+            timeoutMillis = atoi(argv[i + 1]) * 1000;
+        }
+    }
+
+    int fd = openPort(argv[2], baud);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    if (command != nullptr)
+    {
+        writeAll(fd, reinterpret_cast<const uint8_t*>(command), strlen(command));
+        writeAll(fd, reinterpret_cast<const uint8_t*>("\n"), 1);
+    }
+    int result = (strcmp(argv[1], "dump") == 0) ? dump(fd, argv[3]) : restore(fd, argv[3], address);
+    close(fd);
+    return result;
+}
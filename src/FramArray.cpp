@@ -0,0 +1,245 @@
+/* FramArray.cpp
+ *
+ * Description:  FramArray concatenates the memory of multiple FRAM chips into a single linear address space.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramArray.h"
+
+
+// --- Public -----------------------------------------------------------------
+
+FramArray::FramArray()
+{
+    // Empty. All initialization is done in begin().
+}
+
+
+FramArray::ResultCode FramArray::begin(FramI2C* const frams[], const uint8_t framCount)
+{
+    if (initialized_)
+    {
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (frams == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if (framCount == 0 || framCount > MaxChipCount)
+    {
+        return FramI2C::ResultCode::InvalidChipCountError;
+    }
+
+    uint32_t startAddress = 0;
+    for (uint8_t i = 0; i < framCount; ++i)
+    {
+        if (frams[i] == nullptr)
+        {
+            return FramI2C::ResultCode::NullPtrError;
+        }
+        if (!frams[i]->isInitialized())
+        {
+            return FramI2C::ResultCode::NotInitializedError;
+        }
+        frams_[i] = frams[i];
+        chipStartAddress_[i] = startAddress;
+        startAddress += frams[i]->memorySize();
+    }
+    chipStartAddress_[framCount] = startAddress;
+    chipCount_ = framCount;
+    initialized_ = true;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+void FramArray::end(void)
+{
+    initialized_ = false;
+    chipCount_ = 0;
+}
+
+
+bool FramArray::isInitialized(void) const
+{
+    return initialized_;
+}
+
+
+uint8_t FramArray::chipCount(void) const
+{
+    return chipCount_;
+}
+
+
+uint32_t FramArray::memorySize(void) const
+{
+    return initialized_ ? chipStartAddress_[chipCount_] : 0;
+}
+
+
+FramI2C* FramArray::chip(const uint8_t index) const
+{
+    return (index < chipCount_) ? frams_[index] : nullptr;
+}
+
+
+uint32_t FramArray::chipStartAddress(const uint8_t index) const
+{
+    return (index < chipCount_) ? chipStartAddress_[index] : 0;
+}
+
+
+FramArray::ResultCode FramArray::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data) const
+{
+    // Reads byteCount bytes starting at address into data.
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    return transfer(Operation::Read, address, byteCount, data, 0);
+}
+
+
+FramArray::ResultCode FramArray::writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data) const
+{
+    // Writes byteCount bytes from data starting at address.
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    // data is only read from for Operation::Write.
+    return transfer(Operation::Write, address, byteCount, const_cast<uint8_t*>(data), 0);
+}
+
+
+FramArray::ResultCode FramArray::fill(const uint32_t address, const size_t byteCount, const uint8_t value) const
+{
+    // Fills byteCount bytes starting at address with value.
+    return transfer(Operation::Fill, address, byteCount, nullptr, value);
+}
+
+
+// --- Private ----------------------------------------------------------------
+
+FramArray::ResultCode FramArray::readElements(const uint32_t address, const size_t elementSize, const size_t elementCount, uint8_t* const data, const FramByteOrder byteOrder) const
+{
+    // Reads elementCount elements of elementSize bytes and converts them from byteOrder in place.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (elementCount > memorySize() / elementSize)
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    ResultCode resultcode = readBytes(address, elementSize * elementCount, data);
+    if (resultcode == FramI2C::ResultCode::Success && FramI2CEndian::needsSwap(byteOrder))
+    {
+        FramI2CEndian::swap(data, elementSize, elementCount);
+    }
+    return resultcode;
+}
+
+
+FramArray::ResultCode FramArray::writeElements(const uint32_t address, const size_t elementSize, const size_t elementCount, const uint8_t* const data, const FramByteOrder byteOrder) const
+{
+    // Writes elementCount elements of elementSize bytes, converted to byteOrder.
+    // With conversion the elements are written in chunks that fit the smallest I2C chunk of all chips.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (elementCount > memorySize() / elementSize)
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    const size_t byteCount = elementSize * elementCount;
+    if (!FramI2CEndian::needsSwap(byteOrder))
+    {
+        return writeBytes(address, byteCount, data);
+    }
+
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= memorySize()) || byteCount > (memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    size_t chunkSize = FramI2CEndian::SwapBufferSize;
+    for (uint8_t i = 0; i < chipCount_; ++i)
+    {
+        size_t chipChunkSize = frams_[i]->i2cBufferLength() - frams_[i]->addressBytesCount();
+        chunkSize = (chipChunkSize < chunkSize) ? chipChunkSize : chunkSize;
+    }
+    return FramI2CEndian::writeSwapped(*this, address, elementSize, elementCount, data, chunkSize);
+}
+
+
+FramArray::ResultCode FramArray::transfer(const Operation operation, const uint32_t address, const size_t byteCount, uint8_t* const data, const uint8_t value) const
+{
+    // The complete range is validated once. After that the chips are walked consecutively
+    // and each chip's pages are transferred directly, without re-validating every part.
+    // Each chip is only checked to be initialized (it may have been end()ed) when it is entered.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((address >= memorySize()) || byteCount > (memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    uint8_t chipIndex = 0;
+    while (address >= chipStartAddress_[chipIndex + 1])
+    {
+        ++chipIndex;
+    }
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    const FramI2C* fram = nullptr;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        if (fram == nullptr || spanAddress >= chipStartAddress_[chipIndex + 1])
+        {
+            chipIndex = (fram == nullptr) ? chipIndex : chipIndex + 1;
+            fram = frams_[chipIndex];
+            if (!fram->initialized_)
+            {
+                return FramI2C::ResultCode::NotInitializedError;
+            }
+        }
+
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t spanSize = fram->pageSpan(spanAddress - chipStartAddress_[chipIndex], totalBytesRemaining, pageI2cAddress, pageAddress);
+        switch (operation)
+        {
+            case Operation::Read:
+                resultcode = fram->readPage(pageI2cAddress, pageAddress, spanSize, data + (spanAddress - address));
+                break;
+            case Operation::Write:
+                resultcode = fram->writePage(pageI2cAddress, pageAddress, spanSize, data + (spanAddress - address));
+                break;
+            case Operation::Fill:
+                resultcode = fram->fillPage(pageI2cAddress, pageAddress, spanSize, value);
+                break;
+        }
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return resultcode;
+}
+
+
+/* eof */
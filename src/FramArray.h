@@ -0,0 +1,129 @@
+/* FramArray.h
+ *
+ * Description:  FramArray concatenates the memory of multiple FRAM chips (up to 8) into a single
+ *               linear address space. The chips may have different densities and may be on
+ *               different I2C buses. Each chip is accessed via its own (initialized) FramI2C instance.
+ *               Reads, writes and fills that span multiple chips are split automatically.
+ *
+ *               Example usage (two 64 kb FRAM chips on I2C addresses 0x50 and 0x51):
+ *                 FramI2C fram0;
+ *                 FramI2C fram1;
+ *                 FramArray framArray;
+ *                 fram0.begin(64, 0x50);
+ *                 fram1.begin(64, 0x51);
+ *                 FramI2C* frams[] = {&fram0, &fram1};
+ *                 framArray.begin(frams, 2);
+ *                 framArray.writeBytes(0x1FF0, sizeof(data), data);    // Written to both chips.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMARRAY_H_
+#define FRAMARRAY_H_
+
+#include "FramI2C.h"
+
+
+class FramArray
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    static const uint8_t MaxChipCount = 8;
+
+    FramArray();
+
+    // frams contains framCount pointers to initialized FramI2C instances.
+    // The order of frams determines the order of the chips in the linear address space.
+    ResultCode begin(FramI2C* const frams[], const uint8_t framCount);
+    void end(void);
+
+    bool isInitialized(void) const;
+    uint8_t chipCount(void) const;
+    uint32_t memorySize(void) const;
+    FramI2C* chip(const uint8_t index) const;
+    uint32_t chipStartAddress(const uint8_t index) const;
+
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data) const;
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data) const;
+    ResultCode fill(const uint32_t address, const size_t byteCount, const uint8_t value) const;
+
+
+    template<typename T> ResultCode read(const uint32_t address, T& t) const
+    {
+        // Generic read method.
+        // Sets value of output parameter t to value read from address.
+        // If the read fails the value of t is undefined.
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        return readBytes(address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
+    }
+
+
+    template<typename T> ResultCode write(const uint32_t address, const T& t) const
+    {
+        // Generic write method.
+        // Writes input parameter t's value to address.
+        static_assert(__is_trivially_copyable(T), "write() requires a trivially copyable type");
+        return writeBytes(address, sizeof(T), reinterpret_cast<const uint8_t*>(&t));
+    }
+
+
+    template<typename T> ResultCode readArray(const uint32_t address, T* const elements, const size_t elementCount) const
+    {
+        // Reads elementCount elements of type T starting at address, see FramI2C.
+        // Arrays that span multiple chips are split automatically.
+        static_assert(__is_trivially_copyable(T), "readArray() requires a trivially copyable type");
+        return readElements(address, sizeof(T), elementCount, reinterpret_cast<uint8_t*>(elements), FramByteOrder::Native);
+    }
+
+
+    template<typename T> ResultCode readArray(const uint32_t address, T* const elements, const size_t elementCount, const FramByteOrder byteOrder) const
+    {
+        static_assert(__is_trivially_copyable(T), "readArray() requires a trivially copyable type");
+        static_assert(FramByteOrderType<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+            "Byte order conversion requires an integral or floating point type");
+        return readElements(address, sizeof(T), elementCount, reinterpret_cast<uint8_t*>(elements), byteOrder);
+    }
+
+
+    template<typename T> ResultCode writeArray(const uint32_t address, const T* const elements, const size_t elementCount) const
+    {
+        // Writes elementCount elements of type T starting at address, see FramI2C.
+        static_assert(__is_trivially_copyable(T), "writeArray() requires a trivially copyable type");
+        return writeElements(address, sizeof(T), elementCount, reinterpret_cast<const uint8_t*>(elements), FramByteOrder::Native);
+    }
+
+
+    template<typename T> ResultCode writeArray(const uint32_t address, const T* const elements, const size_t elementCount, const FramByteOrder byteOrder) const
+    {
+        static_assert(__is_trivially_copyable(T), "writeArray() requires a trivially copyable type");
+        static_assert(FramByteOrderType<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+            "Byte order conversion requires an integral or floating point type");
+        return writeElements(address, sizeof(T), elementCount, reinterpret_cast<const uint8_t*>(elements), byteOrder);
+    }
+
+
+private:
+
+    enum class Operation : uint8_t
+    {
+        Read,
+        Write,
+        Fill
+    };
+
+    FramI2C* frams_[MaxChipCount];
+    uint32_t chipStartAddress_[MaxChipCount + 1];     // Last element is total memory size.
+    uint8_t chipCount_ = 0;
+    bool initialized_ = false;
+
+    ResultCode readElements(const uint32_t address, const size_t elementSize, const size_t elementCount, uint8_t* const data, const FramByteOrder byteOrder) const;
+    ResultCode writeElements(const uint32_t address, const size_t elementSize, const size_t elementCount, const uint8_t* const data, const FramByteOrder byteOrder) const;
+    ResultCode transfer(const Operation operation, const uint32_t address, const size_t byteCount, uint8_t* const data, const uint8_t value) const;
+};
+
+#endif  //FRAMARRAY_H_
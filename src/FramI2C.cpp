@@ -8,8 +8,14 @@
  * 
  */
 
-#include <Wire.h>
 #include "FramI2C.h"
+#if defined(ARDUINO)
+#include <Wire.h>
+#include "FramI2CWireBus.h"
+
+// Bus used by begin() when no bus is specified.
+static FramI2CWireBus defaultWireBus(Wire);
+#endif
 
 
 // --- Public -----------------------------------------------------------------
@@ -21,24 +27,37 @@ FramI2C::FramI2C()
 
 
 FramI2C::~FramI2C()
-{   // Deallocate buffer (if size > 0 and end() was not called).
-    if (typebuffer_ != nullptr)
-    {
-        delete[] typebuffer_;
-    }
+{
+    // Empty. FramI2C does not allocate memory.
+}
+
+
+#if defined(ARDUINO)
+FramI2C::ResultCode FramI2C::begin(const uint16_t densityInKiloBits, const uint8_t i2cAddress, const size_t typebufferSize, const size_t i2cBufferLength)
+{
+    // Overload without bus parameter, uses the global Wire instance.
+    return begin(defaultWireBus, densityInKiloBits, i2cAddress, typebufferSize, i2cBufferLength);
 }
+#endif
 
 
-FramI2C::ResultCode FramI2C::begin(const uint16_t densityInKiloBits, const uint8_t i2cAddress, const size_t typebufferSize)
+FramI2C::ResultCode FramI2C::begin(FramI2CBus& bus, const uint16_t densityInKiloBits, const uint8_t i2cAddress, const size_t typebufferSize, const size_t i2cBufferLength)
 {
     // Initialization method for the FramI2C class instance. This method shall only be called once.
-    // The application must first initialize the I2C interface by calling Wire.begin()
-    // before FramI2C's begin() method is called.
+    // All I2C transfers are performed via bus. The application must first initialize the
+    // I2C interface used by bus (e.g. by calling Wire.begin()) before FramI2C's begin() method is called.
+    // i2cBufferLength is the maximum number of bytes transferred per I2C transaction (chunk size).
+    // If 0, the buffer length of bus is used (which for Wire is detected per platform).
+    // If densityInKiloBits is AutoDetectDensity the density (and with it page size, page count and
+    // number of address bytes) is detected from the chip, see detectDensity().
+
+    const size_t bufferLength = (i2cBufferLength == 0) ? bus.bufferLength() : i2cBufferLength;
 
     if (initialized_)
     {
         // begin() is called again while already initialized.
-        if (densityInKiloBits == density_ && i2cAddress == i2cAddress_ && typebufferSize == typebufferSize_)
+        if (&bus == bus_ && (densityInKiloBits == density_ || densityInKiloBits == AutoDetectDensity) &&
+            i2cAddress == i2cAddress_ && bufferLength == i2cBufferLength_)
         {
             // Parameters are identical, FramI2C is already initialized identically.
             // While begin() should only be called once, ignore and return success (don't fail if not neccesary).
@@ -51,36 +70,48 @@ FramI2C::ResultCode FramI2C::begin(const uint16_t densityInKiloBits, const uint8
         }
     }
 
-    if (!isDensitySupported(densityInKiloBits))
-    {
-       return FramI2C::ResultCode::UnsupportedDensityError;
-    }    
+    deviceIdChecked_ = false;
+    deviceIdSupported_ = false;
+    manufacturerId_ = 0;
+    productId_ = 0;
 
-    pageSize_ = densityToPageSize(densityInKiloBits);
+    uint16_t density = densityInKiloBits;
+    if (density == AutoDetectDensity)
+    {
+        // Detection accesses the chip via bus_ and i2cAddress_.
+        bus_ = &bus;
+        i2cAddress_ = i2cAddress;
+        density = detectDensity();
+        bus_ = nullptr;
+        i2cAddress_ = 0;
+        if (density == 0)
+        {
+            return FramI2C::ResultCode::DensityDetectionError;
+        }
+    }
 
-    if (typebufferSize > pageSize_)
+    if (!isDensitySupported(density))
     {
-       return FramI2C::ResultCode::BufferAllocationFailedError;
+       return FramI2C::ResultCode::UnsupportedDensityError;
     }    
 
-    // typebuffer_ = new uint8_t[typebufferSize];
-    typebuffer_ = static_cast<uint8_t*>(malloc(typebufferSize));
-    if (typebuffer_ == nullptr)
+    pageSize_ = densityToPageSize(density);
+
+    // The buffer must at least fit the FRAM address bytes plus one data byte.
+    if (bufferLength <= FramI2CGeometry::addressBytesCount(density))
     {
-       return FramI2C::ResultCode::BufferAllocationFailedError;
+       return FramI2C::ResultCode::I2CBufferLengthError;
     }    
 
-    typebufferSize_ = typebufferSize;
+    (void)typebufferSize;   // Not used, read() and write() transfer data directly.
+    i2cBufferLength_ = bufferLength;
+    bus_ = &bus;
     i2cAddress_ = i2cAddress;
-    density_ = densityInKiloBits;
-    memorySize_ = densityToMemorySize(densityInKiloBits);
-    addressBytesCount_ = (pageSize_ == 0x100) ? 1 : 2;
-    pageCount_ = memorySize_ / pageSize_;
+    density_ = density;
+    memorySize_ = densityToMemorySize(density);
+    addressBytesCount_ = FramI2CGeometry::addressBytesCount(density);
+    pageCount_ = FramI2CGeometry::pageCount(density);
     initialized_ = true;
-    deviceIdChecked_ = false;
-    deviceIdSupported_ = false;
-    manufacturerId_ = 0;
-    productId_ = 0;
 
     return FramI2C::ResultCode::Success;
 }
@@ -91,12 +122,8 @@ void FramI2C::end(void)
     // Counterpart of begin().
     // Not required for most uses. Added for completeness.
     initialized_ = false;  
-    if (typebuffer_ != nullptr)
-    {
-        // delete[] typebuffer_;
-        free(typebuffer_);
-    }
-    typebufferSize_ = 0;
+    i2cBufferLength_ = 0;
+    bus_ = nullptr;
     i2cAddress_ = 0;
     density_ = 0;
     memorySize_ = 0;
@@ -128,13 +155,13 @@ uint8_t FramI2C::i2cAddress(void) const
 }
 
 
-size_t FramI2C::memorySize(void) const
+uint32_t FramI2C::memorySize(void) const
 {
     return memorySize_;
 }
 
 
-size_t FramI2C::pageSize(void) const
+uint32_t FramI2C::pageSize(void) const
 {
     return pageSize_;
 }
@@ -148,7 +175,14 @@ uint8_t FramI2C::pageCount(void) const
 
 size_t FramI2C::typebufferSize(void) const
 {
-    return typebufferSize_;
+    // Deprecated. read() and write() no longer use a type buffer.
+    return 0;
+}
+
+
+size_t FramI2C::i2cBufferLength(void) const
+{
+    return i2cBufferLength_;
 }
 
 
@@ -188,21 +222,95 @@ uint16_t FramI2C::productId(void) const
 }
 
 
-FramI2C::ResultCode FramI2C::readBytes(const uint16_t address, const size_t byteCount, uint8_t* const data) const
+bool FramI2C::streamingRead(void) const
+{
+    return streamingRead_;
+}
+
+
+void FramI2C::setStreamingRead(const bool enabled)
+{
+    // When streaming read is enabled (default), readBytes() sets the FRAM address only once
+    // and reads all chunks with 'current address reads' (FRAM auto-increments its address latch).
+    // Disable streaming read if the same FRAM chip can be accessed by another I2C master
+    // in between chunks (which would change the FRAM's address latch).
+    streamingRead_ = enabled;
+}
+
+
+bool FramI2C::writeVerify(void) const
+{
+    return writeVerify_;
+}
+
+
+void FramI2C::setWriteVerify(const bool enabled)
+{
+    // When write verify is enabled, every chunk written by writeBytes(), writev(), write(), writeArray()
+    // and copy() is read back and compared immediately after it has been written. A difference results
+    // in VerifyError. This doubles the bus traffic of writes, fills are not verified.
+    writeVerify_ = enabled;
+}
+
+
+FramI2CWriteObserver* FramI2C::writeObserver(void) const
 {
-	// Overload without page parameter.
-    return FramI2C::readBytes(0, address, byteCount, data);
+    return writeObserver_;
+}
+
+
+void FramI2C::setWriteObserver(FramI2CWriteObserver* const observer)
+{
+    // The observer is notified of all writes and fills, including those made via FramArray and FramStripe.
+    writeObserver_ = observer;
+}
+
+
+FramI2C::ResultCode FramI2C::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data) const
+{
+    // Reads byteCount bytes starting at linear memory address (0 to memorySize - 1) into data.
+    // For FRAM with multiple pages the linear address space spans all pages (page 1 starts at pageSize).
+    // Ranges that cross page boundaries are automatically split into separate transfers per page.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t spanSize = pageSpan(spanAddress, totalBytesRemaining, pageI2cAddress, pageAddress);
+        resultcode = readPage(pageI2cAddress, pageAddress, spanSize, data + (spanAddress - address));
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return resultcode;
 }
 
 
 FramI2C::ResultCode FramI2C::readBytes(const uint8_t page, const uint16_t address, const size_t byteCount, uint8_t* const data) const
 {
     // Reads byteCount bytes from the specified FRAM page starting at memory address into data.
-    // The Wire library's I2C buffer has a limited size of 32 bytes. When byteCount is larger
+    // The I2C buffer has a limited size (32 bytes for AVR Wire). When byteCount is larger
     // than the I2C buffer, data will automatically be transmitted in multiple smaller chunks.    
-    // Data is read in chunks that are (max) 32 bytes in size.    
+    // Data is read in chunks that are (max) i2cBufferLength bytes in size.    
     //
     // The read operation performed is described in datasheets as 'selective address read' (because address is specified).
+    // With streaming read enabled only the first chunk is read with a selective address read,
+    // subsequent chunks are read with a 'current address read' (which does not transmit the address).
 
     if (!initialized_)
     {
@@ -216,57 +324,77 @@ FramI2C::ResultCode FramI2C::readBytes(const uint8_t page, const uint16_t addres
     {
         return FramI2C::ResultCode::InvalidPageError;
     }
-    if ((address >= pageSize_) || (address + byteCount) > pageSize_)
+    if ((address >= pageSize_) || byteCount > (pageSize_ - address))
     {
         return FramI2C::ResultCode::PageSizeRangeError;
     }
 
-    uint8_t pageI2cAddress = i2cAddress_ + page;
-    uint8_t* dataChunk = data;
+    return readPage(i2cAddress_ + page, address, byteCount, data);
+}
+
+
+FramI2C::ResultCode FramI2C::readPage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, uint8_t* const data) const
+{
+    // Reads byteCount bytes from the FRAM page at pageI2cAddress. Parameters are not checked.
+
+    FramI2CReadSegment segment = {data, byteCount};
+    const FramI2CReadSegment* segmentPtr = &segment;
+    size_t segmentOffset = 0;
+    return readPageSegments(pageI2cAddress, address, byteCount, segmentPtr, segmentOffset);
+}
+
+
+FramI2C::ResultCode FramI2C::readPageChunks(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, PageChunkSink& sink) const
+{
+    // Reads byteCount bytes from the FRAM page at pageI2cAddress in I2C buffer sized chunks and hands each
+    // chunk, while it is in the I2C receive buffer, to sink. With streaming read the address is only set
+    // for the first chunk. Parameters are not checked.
+
     uint16_t framChunkAddress = address;    
     size_t totalBytesRemaining = byteCount;
 
+    bool setAddress = true;
+
     while (totalBytesRemaining > 0)
     {
-        size_t chunkSize = (totalBytesRemaining > I2CBufferLength) ? I2CBufferLength : totalBytesRemaining;
+        size_t chunkSize = (totalBytesRemaining > i2cBufferLength_) ? i2cBufferLength_ : totalBytesRemaining;
 
-        size_t bytesQueued = 0;
-        Wire.beginTransmission(pageI2cAddress);
-        if (addressBytesCount_ > 1)
-        {
-            bytesQueued += Wire.write(framChunkAddress >> 8);
-        }
-        bytesQueued += Wire.write(framChunkAddress & 0xFF);
-        if (bytesQueued != addressBytesCount_)
-        {
-            return FramI2C::ResultCode::I2CWriteError;
-        }  
-        uint8_t twiresult = Wire.endTransmission();
-        if (twiresult != TwiSuccess)
+        if (setAddress)
         {
-            return twiCodeToResultCode(twiresult);
+            size_t bytesQueued = 0;
+            bus_->beginTransmission(pageI2cAddress);
+            if (addressBytesCount_ > 1)
+            {
+                bytesQueued += bus_->write(framChunkAddress >> 8);
+            }
+            bytesQueued += bus_->write(framChunkAddress & 0xFF);
+            if (bytesQueued != addressBytesCount_)
+            {
+                return FramI2C::ResultCode::I2CWriteError;
+            }  
+            uint8_t twiresult = bus_->endTransmission(true);
+            if (twiresult != FramI2CBus::TwiSuccess)
+            {
+                return twiCodeToResultCode(twiresult);
+            }
+            setAddress = !streamingRead_;
         }
 
         // Read chunk from FRAM into I2C buffer.
-        size_t bytesRead = Wire.requestFrom(pageI2cAddress, chunkSize, true);       
+        size_t bytesRead = bus_->requestFrom(pageI2cAddress, chunkSize, true);       
         if (bytesRead != chunkSize)
         {
             return FramI2C::ResultCode::I2CReadError;
         }
 
-        // Copy chunk from I2C buffer to data.
-        if (chunkSize == 1)  
-        {
-            dataChunk[0] = Wire.read();  //Is a tiny bit faster for single byte.
-        }
-        else
+        ResultCode resultcode = sink.takeChunk(*bus_, byteCount - totalBytesRemaining, chunkSize);
+        if (resultcode != FramI2C::ResultCode::Success)
         {
-            Wire.readBytes(dataChunk, chunkSize);
+            return resultcode;
         }
         
         totalBytesRemaining -= chunkSize;
         framChunkAddress += chunkSize;
-        dataChunk += chunkSize;
 #if defined(ESP8266)        
         // If ESP8266 MCU yield() after reading every chunk to prevent WDT reset.
         yield();
@@ -276,19 +404,316 @@ FramI2C::ResultCode FramI2C::readBytes(const uint8_t page, const uint16_t addres
 }
 
 
-FramI2C::ResultCode FramI2C::writeBytes(const uint16_t address, const size_t byteCount, const uint8_t* const data) const
+FramI2C::ResultCode FramI2C::readPageSegments(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+    const FramI2CReadSegment*& segment, size_t& segmentOffset) const
 {
-	// Overload without page parameter.
-    return writeBytes(0, address, byteCount, data);
+    // Reads byteCount bytes from the FRAM page at pageI2cAddress into consecutive segments,
+    // starting at segmentOffset in segment. segment and segmentOffset are advanced past the bytes read.
+    // Segment boundaries do not affect the I2C chunks. Parameters are not checked.
+
+    class CopySink : public PageChunkSink
+    {
+    public:
+        CopySink(const FramI2CReadSegment*& segment, size_t& segmentOffset) : segment_(segment), segmentOffset_(segmentOffset) {}
+
+        ResultCode takeChunk(FramI2CBus& bus, const size_t, const size_t chunkSize) override
+        {
+            // Copy chunk from I2C buffer to the segments.
+            size_t chunkBytesRemaining = chunkSize;
+            while (chunkBytesRemaining > 0)
+            {
+                while (segmentOffset_ == segment_->byteCount)
+                {
+                    ++segment_;
+                    segmentOffset_ = 0;
+                }
+                size_t pieceSize = segment_->byteCount - segmentOffset_;
+                pieceSize = (pieceSize < chunkBytesRemaining) ? pieceSize : chunkBytesRemaining;
+                if (pieceSize == 1)  
+                {
+                    segment_->data[segmentOffset_] = bus.read();  //Is a tiny bit faster for single byte.
+                }
+                else
+                {
+                    bus.readBytes(segment_->data + segmentOffset_, pieceSize);
+                }
+                segmentOffset_ += pieceSize;
+                chunkBytesRemaining -= pieceSize;
+            }
+            return FramI2C::ResultCode::Success;
+        }
+
+    private:
+        const FramI2CReadSegment*& segment_;
+        size_t& segmentOffset_;
+    };
+
+    CopySink sink(segment, segmentOffset);
+    return readPageChunks(pageI2cAddress, address, byteCount, sink);
+}
+
+
+FramI2C::ResultCode FramI2C::compare(const uint32_t address, const size_t byteCount, const uint8_t* const expected, size_t& mismatchOffset) const
+{
+    // Compares byteCount bytes starting at linear memory address with expected.
+    // Ranges that cross page boundaries are automatically split into separate transfers per page.
+
+    mismatchOffset = byteCount;
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (expected == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    FramI2CWriteSegment segment = {expected, byteCount};
+    const FramI2CWriteSegment* segmentPtr = &segment;
+    size_t segmentOffset = 0;
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t pageMismatchOffset;
+        size_t spanSize = pageSpan(spanAddress, totalBytesRemaining, pageI2cAddress, pageAddress);
+        resultcode = comparePageSegments(pageI2cAddress, pageAddress, spanSize, segmentPtr, segmentOffset, pageMismatchOffset);
+        if (resultcode == FramI2C::ResultCode::VerifyError)
+        {
+            mismatchOffset = (spanAddress - address) + pageMismatchOffset;
+        }
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::compare(const uint8_t page, const uint16_t address, const size_t byteCount, const uint8_t* const expected, size_t& mismatchOffset) const
+{
+    // Compares byteCount bytes of the specified FRAM page starting at memory address with expected.
+
+    mismatchOffset = byteCount;
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (expected == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if (page >= pageCount_)
+    {
+        return FramI2C::ResultCode::InvalidPageError;
+    }
+    if ((address >= pageSize_) || byteCount > (pageSize_ - address))
+    {
+        return FramI2C::ResultCode::PageSizeRangeError;
+    }
+
+    FramI2CWriteSegment segment = {expected, byteCount};
+    const FramI2CWriteSegment* segmentPtr = &segment;
+    size_t segmentOffset = 0;
+    return comparePageSegments(i2cAddress_ + page, address, byteCount, segmentPtr, segmentOffset, mismatchOffset);
+}
+
+
+FramI2C::ResultCode FramI2C::comparePageSegments(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+    const FramI2CWriteSegment*& segment, size_t& segmentOffset, size_t& mismatchOffset) const
+{
+    // Compares byteCount bytes of the FRAM page at pageI2cAddress with consecutive segments, starting at
+    // segmentOffset in segment. Chunks are compared piece by piece via a small stack buffer instead of
+    // being stored. Stops at the first difference and returns VerifyError, mismatchOffset is set to the
+    // offset of the difference (byteCount if equal). Parameters are not checked.
+
+    class CompareSink : public PageChunkSink
+    {
+    public:
+        CompareSink(const FramI2CWriteSegment*& segment, size_t& segmentOffset, size_t& mismatchOffset)
+            : segment_(segment), segmentOffset_(segmentOffset), mismatchOffset_(mismatchOffset) {}
+
+        ResultCode takeChunk(FramI2CBus& bus, const size_t chunkOffset, const size_t chunkSize) override
+        {
+            // Compare chunk from I2C buffer with the segments.
+            uint8_t compareBuffer[TransferBufferSize];
+            size_t chunkBytesRemaining = chunkSize;
+            while (chunkBytesRemaining > 0)
+            {
+                while (segmentOffset_ == segment_->byteCount)
+                {
+                    ++segment_;
+                    segmentOffset_ = 0;
+                }
+                size_t pieceSize = segment_->byteCount - segmentOffset_;
+                pieceSize = (pieceSize < chunkBytesRemaining) ? pieceSize : chunkBytesRemaining;
+                pieceSize = (pieceSize < TransferBufferSize) ? pieceSize : TransferBufferSize;
+                bus.readBytes(compareBuffer, pieceSize);
+                const uint8_t* expected = segment_->data + segmentOffset_;
+                if (memcmp(compareBuffer, expected, pieceSize) != 0)
+                {
+                    size_t i = 0;
+                    while (compareBuffer[i] == expected[i])
+                    {
+                        ++i;
+                    }
+                    mismatchOffset_ = chunkOffset + (chunkSize - chunkBytesRemaining) + i;
+                    return FramI2C::ResultCode::VerifyError;
+                }
+                segmentOffset_ += pieceSize;
+                chunkBytesRemaining -= pieceSize;
+            }
+            return FramI2C::ResultCode::Success;
+        }
+
+    private:
+        const FramI2CWriteSegment*& segment_;
+        size_t& segmentOffset_;
+        size_t& mismatchOffset_;
+    };
+
+    mismatchOffset = byteCount;
+    CompareSink sink(segment, segmentOffset, mismatchOffset);
+    return readPageChunks(pageI2cAddress, address, byteCount, sink);
+}
+
+
+FramI2C::ResultCode FramI2C::checksum(const uint32_t address, const size_t byteCount, const FramCrcAlgorithm algorithm, uint32_t& crc) const
+{
+    // Computes the CRC of byteCount bytes starting at linear memory address.
+    // Ranges that cross page boundaries are automatically split into separate transfers per page.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    FramI2CCrc crcEngine(algorithm);
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t spanSize = pageSpan(spanAddress, totalBytesRemaining, pageI2cAddress, pageAddress);
+        resultcode = checksumPage(pageI2cAddress, pageAddress, spanSize, crcEngine);
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    crc = crcEngine.value();
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::checksum(const uint8_t page, const uint16_t address, const size_t byteCount, const FramCrcAlgorithm algorithm, uint32_t& crc) const
+{
+    // Computes the CRC of byteCount bytes of the specified FRAM page starting at memory address.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (page >= pageCount_)
+    {
+        return FramI2C::ResultCode::InvalidPageError;
+    }
+    if ((address >= pageSize_) || byteCount > (pageSize_ - address))
+    {
+        return FramI2C::ResultCode::PageSizeRangeError;
+    }
+
+    FramI2CCrc crcEngine(algorithm);
+    ResultCode resultcode = checksumPage(i2cAddress_ + page, address, byteCount, crcEngine);
+    crc = crcEngine.value();
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::checksumPage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, FramI2CCrc& crc) const
+{
+    // Adds byteCount bytes of the FRAM page at pageI2cAddress to crc. Chunks are drained from
+    // the I2C buffer into crc via a small stack buffer. Parameters are not checked.
+
+    class CrcSink : public PageChunkSink
+    {
+    public:
+        CrcSink(FramI2CCrc& crc) : crc_(crc) {}
+
+        ResultCode takeChunk(FramI2CBus& bus, const size_t, const size_t chunkSize) override
+        {
+            // Add chunk from I2C buffer to the CRC.
+            uint8_t crcBuffer[TransferBufferSize];
+            size_t chunkBytesRemaining = chunkSize;
+            while (chunkBytesRemaining > 0)
+            {
+                size_t pieceSize = (chunkBytesRemaining < TransferBufferSize) ? chunkBytesRemaining : TransferBufferSize;
+                bus.readBytes(crcBuffer, pieceSize);
+                crc_.update(crcBuffer, pieceSize);
+                chunkBytesRemaining -= pieceSize;
+            }
+            return FramI2C::ResultCode::Success;
+        }
+
+    private:
+        FramI2CCrc& crc_;
+    };
+
+    CrcSink sink(crc);
+    return readPageChunks(pageI2cAddress, address, byteCount, sink);
+}
+
+
+FramI2C::ResultCode FramI2C::writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data) const
+{
+    // Writes byteCount bytes from data starting at linear memory address (0 to memorySize - 1).
+    // Ranges that cross page boundaries are automatically split into separate transfers per page.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t spanSize = pageSpan(spanAddress, totalBytesRemaining, pageI2cAddress, pageAddress);
+        resultcode = writePage(pageI2cAddress, pageAddress, spanSize, data + (spanAddress - address));
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return resultcode;
 }
 
 
 FramI2C::ResultCode FramI2C::writeBytes(const uint8_t page, const uint16_t address, const size_t byteCount, const uint8_t* const data) const
 {
     // Writes byteCount bytes from data to the specified FRAM page starting at memory address.
-    // The Wire library's I2C buffer has a limited size of 32 bytes. When byteCount is larger
+    // The I2C buffer has a limited size (32 bytes for AVR Wire). When byteCount is larger
     // than the I2C buffer, data will automatically be transmitted in multiple smaller chunks.    
-    // Data is written in chunks that are (max) 30 or 31 bytes in size.
+    // Data is written in chunks that are (max) i2cBufferLength - 2 or i2cBufferLength - 1 bytes in size.
     // 
     // When writing to FRAM the memory address needs to be included in the I2C buffer, therefore the
     // size of data that can be written per chunk is smaller than the size of the I2C buffer.
@@ -306,38 +731,135 @@ FramI2C::ResultCode FramI2C::writeBytes(const uint8_t page, const uint16_t addre
     {
         return FramI2C::ResultCode::InvalidPageError;
     }
-    if ((address >= pageSize_) || (address + byteCount) > pageSize_)
+    if ((address >= pageSize_) || byteCount > (pageSize_ - address))
     {
         return FramI2C::ResultCode::PageSizeRangeError;
     }    
 
-    uint8_t pageI2cAddress = i2cAddress_ + page;
-    const uint8_t* dataChunk = data;
+    return writePage(i2cAddress_ + page, address, byteCount, data);
+}
+
+
+FramI2C::ResultCode FramI2C::readv(const uint32_t address, const FramI2CReadSegment* const segments, const size_t segmentCount) const
+{
+    // Reads one contiguous FRAM range starting at linear address into segmentCount segments (scatter read).
+    // The range is as large as the sum of the segment sizes. Segments are filled in order and are
+    // packed into the same I2C chunks: segment boundaries do not cause additional I2C transactions.
+
+    size_t byteCount = 0;
+    ResultCode resultcode = checkSegments(address, segments, segmentCount, byteCount);
+    if (resultcode != FramI2C::ResultCode::Success)
+    {
+        return resultcode;
+    }
+
+    const FramI2CReadSegment* segment = segments;
+    size_t segmentOffset = 0;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t spanSize = pageSpan(spanAddress, totalBytesRemaining, pageI2cAddress, pageAddress);
+        resultcode = readPageSegments(pageI2cAddress, pageAddress, spanSize, segment, segmentOffset);
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::writev(const uint32_t address, const FramI2CWriteSegment* const segments, const size_t segmentCount) const
+{
+    // Writes segmentCount segments to one contiguous FRAM range starting at linear address (gather write).
+    // Segments are packed into the same I2C chunks, e.g. header, payload and CRC in separate buffers
+    // are written with the same number of transactions as a single buffer.
+
+    size_t byteCount = 0;
+    ResultCode resultcode = checkSegments(address, segments, segmentCount, byteCount);
+    if (resultcode != FramI2C::ResultCode::Success)
+    {
+        return resultcode;
+    }
+
+    const FramI2CWriteSegment* segment = segments;
+    size_t segmentOffset = 0;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t spanSize = pageSpan(spanAddress, totalBytesRemaining, pageI2cAddress, pageAddress);
+        resultcode = writePageSegments(pageI2cAddress, pageAddress, spanSize, segment, segmentOffset);
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::writePage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, const uint8_t* const data) const
+{
+    // Writes byteCount bytes to the FRAM page at pageI2cAddress. Parameters are not checked.
+
+    FramI2CWriteSegment segment = {data, byteCount};
+    const FramI2CWriteSegment* segmentPtr = &segment;
+    size_t segmentOffset = 0;
+    return writePageSegments(pageI2cAddress, address, byteCount, segmentPtr, segmentOffset);
+}
+
+
+FramI2C::ResultCode FramI2C::writePageSegments(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+    const FramI2CWriteSegment*& segment, size_t& segmentOffset) const
+{
+    // Writes byteCount bytes from consecutive segments, starting at segmentOffset in segment, to the FRAM page
+    // at pageI2cAddress. segment and segmentOffset are advanced past the bytes written.
+    // Segment boundaries do not affect the I2C chunks. Parameters are not checked.
+
+    notifyWriteObserver(pageI2cAddress, address, byteCount);
+
     uint16_t framChunkAddress = address;
     size_t totalBytesRemaining = byteCount;
-    size_t i2cBufferUsableLength = I2CBufferLength - addressBytesCount_;
+    size_t i2cBufferUsableLength = i2cBufferLength_ - addressBytesCount_;
     ResultCode resultcode = ResultCode::Success;
 
     while(totalBytesRemaining > 0)
     {
         size_t chunkSize = (totalBytesRemaining > i2cBufferUsableLength) ? i2cBufferUsableLength : totalBytesRemaining;
+        const FramI2CWriteSegment* chunkSegment = segment;
+        size_t chunkSegmentOffset = segmentOffset;
         
         size_t bytesQueued = 0;
-        Wire.beginTransmission(pageI2cAddress);
+        bus_->beginTransmission(pageI2cAddress);
         if (addressBytesCount_ > 1)
         {
-            bytesQueued += Wire.write(framChunkAddress >> 8);   //MSB
+            bytesQueued += bus_->write(framChunkAddress >> 8);   //MSB
         }
-        bytesQueued += Wire.write(framChunkAddress & 0xFF);     //LSB
+        bytesQueued += bus_->write(framChunkAddress & 0xFF);     //LSB
         
-        // Copy chunk from data to I2C buffer.      
-        if (chunkSize == 1)
-        {
-            bytesQueued += Wire.write(dataChunk[0]);    //Is a tiny bit faster for single byte.
-        }
-        else
+        // Copy chunk from the segments to I2C buffer.
+        size_t chunkBytesRemaining = chunkSize;
+        while (chunkBytesRemaining > 0)
         {
-            bytesQueued += Wire.write(dataChunk, chunkSize);
+            while (segmentOffset == segment->byteCount)
+            {
+                ++segment;
+                segmentOffset = 0;
+            }
+            size_t pieceSize = segment->byteCount - segmentOffset;
+            pieceSize = (pieceSize < chunkBytesRemaining) ? pieceSize : chunkBytesRemaining;
+            if (pieceSize == 1)
+            {
+                bytesQueued += bus_->write(segment->data[segmentOffset]);    //Is a tiny bit faster for single byte.
+            }
+            else
+            {
+                bytesQueued += bus_->write(segment->data + segmentOffset, pieceSize);
+            }
+            segmentOffset += pieceSize;
+            chunkBytesRemaining -= pieceSize;
         }
         
         if (bytesQueued != addressBytesCount_ + chunkSize)
@@ -346,15 +868,25 @@ FramI2C::ResultCode FramI2C::writeBytes(const uint8_t page, const uint16_t addre
         }  
 
         // Transmit I2C buffer to FRAM.
-        uint8_t twiresult = Wire.endTransmission();
-        if (twiresult != TwiSuccess)
+        uint8_t twiresult = bus_->endTransmission(true);
+        if (twiresult != FramI2CBus::TwiSuccess)
         {
             return twiCodeToResultCode(twiresult);
         }
+
+        // Read back the chunk and compare it with the data just written.
+        if (writeVerify_)
+        {
+            size_t mismatchOffset;
+            resultcode = comparePageSegments(pageI2cAddress, framChunkAddress, chunkSize, chunkSegment, chunkSegmentOffset, mismatchOffset);
+            if (resultcode != FramI2C::ResultCode::Success)
+            {
+                return resultcode;
+            }
+        }
         
         totalBytesRemaining -= chunkSize;
         framChunkAddress += chunkSize;
-        dataChunk += chunkSize;
 #if defined(ESP8266)        
         // If ESP8266 MCU yield() after writing every chunk to prevent WDT reset.
         yield();
@@ -364,10 +896,188 @@ FramI2C::ResultCode FramI2C::writeBytes(const uint8_t page, const uint16_t addre
 }
 
 
-FramI2C::ResultCode FramI2C::fill(const uint16_t address, const size_t byteCount, const uint8_t value) const
+FramI2C::ResultCode FramI2C::fill(const uint32_t address, const size_t byteCount, const uint8_t value) const
+{
+    // Fills byteCount bytes starting at linear memory address (0 to memorySize - 1), with value.
+    // Ranges that cross page boundaries are automatically split into separate transfers per page.
+
+    return fillPattern(address, byteCount, &value, 1);
+}
+
+
+FramI2C::ResultCode FramI2C::fillPattern(const uint32_t address, const size_t byteCount, const uint8_t* const pattern, const size_t patternSize) const
+{
+    // Fills byteCount bytes starting at linear memory address with repetitions of the patternSize bytes in pattern.
+    // pattern[0] is written at address. If byteCount is not a multiple of patternSize the last repetition is partial.
+    // The pattern is repeated in a buffer once, after which every I2C chunk is queued with bulk writes.
+    // An empty pattern (patternSize 0) can only fill an empty range.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (pattern == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address) || (patternSize == 0 && byteCount > 0))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    if (byteCount == 0)
+    {
+        return FramI2C::ResultCode::Success;
+    }
+
+    uint8_t patternBuffer[PatternBufferSize];
+    const uint8_t* cycle = pattern;
+    size_t cycleSize = patternSize;
+    if (patternSize <= PatternBufferSize / 2)
+    {
+        // Small patterns are repeated to (almost) fill the buffer, so that chunks are queued in a few large pieces.
+        cycleSize = (PatternBufferSize / patternSize) * patternSize;
+        for (size_t i = 0; i < cycleSize; i += patternSize)
+        {
+            memcpy(patternBuffer + i, pattern, patternSize);
+        }
+        cycle = patternBuffer;
+    }
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    size_t cycleOffset = 0;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t spanSize = pageSpan(spanAddress, totalBytesRemaining, pageI2cAddress, pageAddress);
+        resultcode = fillPagePattern(pageI2cAddress, pageAddress, spanSize, cycle, cycleSize, cycleOffset);
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::erase(const uint8_t value) const
+{
+    // Fills the complete memory with value, using maximum size I2C chunks.
+    // Filled in spans of at most 0x8000 bytes, because size_t is 16-bit on AVR.
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    uint32_t address = 0;
+    while (address < memorySize_ && resultcode == FramI2C::ResultCode::Success)
+    {
+        size_t byteCount = (memorySize_ - address < 0x8000) ? static_cast<size_t>(memorySize_ - address) : 0x8000;
+        resultcode = fill(address, byteCount, value);
+        address += byteCount;
+    }
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::copy(const uint32_t sourceAddress, const uint32_t destinationAddress, const size_t byteCount) const
+{
+    // Copies byteCount bytes from linear address sourceAddress to destinationAddress.
+    // Source and destination may overlap (memmove semantics).
+
+    return copy(*this, sourceAddress, *this, destinationAddress, byteCount);
+}
+
+
+FramI2C::ResultCode FramI2C::copy(const uint8_t sourcePage, const uint16_t sourceAddress,
+    const uint8_t destinationPage, const uint16_t destinationAddress, const size_t byteCount) const
+{
+    // Copies byteCount bytes within or between pages. Source and destination range must each fit in their page.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (sourcePage >= pageCount_ || destinationPage >= pageCount_)
+    {
+        return FramI2C::ResultCode::InvalidPageError;
+    }
+    if ((sourceAddress >= pageSize_) || byteCount > (pageSize_ - sourceAddress) ||
+        (destinationAddress >= pageSize_) || byteCount > (pageSize_ - destinationAddress))
+    {
+        return FramI2C::ResultCode::PageSizeRangeError;
+    }
+
+    return copy(*this, static_cast<uint32_t>(sourcePage) * pageSize_ + sourceAddress,
+        *this, static_cast<uint32_t>(destinationPage) * pageSize_ + destinationAddress, byteCount);
+}
+
+
+FramI2C::ResultCode FramI2C::copy(const FramI2C& source, const uint32_t sourceAddress,
+    const FramI2C& destination, const uint32_t destinationAddress, const size_t byteCount)
 {
-	// Overload without page parameter.
-    return fill(0, address, byteCount, value);
+    // Copies byteCount bytes from source to destination (linear addressing), e.g. between two chips.
+    // Data is transferred through a small stack buffer: every chunk is read from the source with a single
+    // I2C read and written to the destination with a single I2C write, chunks never cross a page boundary.
+    // If source and destination are the same instance and the destination overlaps the end of the
+    // source range, chunks are copied from the end backwards (memmove semantics).
+
+    if (!source.initialized_ || !destination.initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((sourceAddress >= source.memorySize_) || byteCount > (source.memorySize_ - sourceAddress) ||
+        (destinationAddress >= destination.memorySize_) || byteCount > (destination.memorySize_ - destinationAddress))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    if (byteCount == 0 || (&source == &destination && sourceAddress == destinationAddress))
+    {
+        return FramI2C::ResultCode::Success;
+    }
+
+    uint8_t copyBuffer[TransferBufferSize];
+    size_t chunkLimit = TransferBufferSize;
+    chunkLimit = (source.i2cBufferLength_ < chunkLimit) ? source.i2cBufferLength_ : chunkLimit;
+    size_t destinationChunkLimit = destination.i2cBufferLength_ - destination.addressBytesCount_;
+    chunkLimit = (destinationChunkLimit < chunkLimit) ? destinationChunkLimit : chunkLimit;
+    const bool backwards = (&source == &destination) && (destinationAddress > sourceAddress) &&
+        (destinationAddress < sourceAddress + byteCount);
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0 && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint8_t sourcePageI2cAddress;
+        uint16_t sourcePageAddress;
+        uint8_t destinationPageI2cAddress;
+        uint16_t destinationPageAddress;
+        size_t chunkSize = (totalBytesRemaining < chunkLimit) ? totalBytesRemaining : chunkLimit;
+        uint32_t offset;
+        if (backwards)
+        {
+            // The chunk ends at offset totalBytesRemaining and must not cross a page boundary going down.
+            uint32_t sourceEnd = sourceAddress + totalBytesRemaining;
+            uint32_t destinationEnd = destinationAddress + totalBytesRemaining;
+            uint32_t sourceBytesFromPageStart = (sourceEnd - 1) % source.pageSize_ + 1;
+            uint32_t destinationBytesFromPageStart = (destinationEnd - 1) % destination.pageSize_ + 1;
+            chunkSize = (sourceBytesFromPageStart < chunkSize) ? sourceBytesFromPageStart : chunkSize;
+            chunkSize = (destinationBytesFromPageStart < chunkSize) ? destinationBytesFromPageStart : chunkSize;
+            offset = totalBytesRemaining - chunkSize;
+            source.pageSpan(sourceAddress + offset, chunkSize, sourcePageI2cAddress, sourcePageAddress);
+            destination.pageSpan(destinationAddress + offset, chunkSize, destinationPageI2cAddress, destinationPageAddress);
+        }
+        else
+        {
+            offset = byteCount - totalBytesRemaining;
+            chunkSize = source.pageSpan(sourceAddress + offset, chunkSize, sourcePageI2cAddress, sourcePageAddress);
+            chunkSize = destination.pageSpan(destinationAddress + offset, chunkSize, destinationPageI2cAddress, destinationPageAddress);
+        }
+
+        resultcode = source.readPage(sourcePageI2cAddress, sourcePageAddress, chunkSize, copyBuffer);
+        if (resultcode == FramI2C::ResultCode::Success)
+        {
+            resultcode = destination.writePage(destinationPageI2cAddress, destinationPageAddress, chunkSize, copyBuffer);
+        }
+        totalBytesRemaining -= chunkSize;
+    }
+    return resultcode;
 }
 
 
@@ -384,15 +1094,38 @@ FramI2C::ResultCode FramI2C::fill(const uint8_t page, const uint16_t address, co
     {
         return FramI2C::ResultCode::InvalidPageError;
     }
-    if ((address >= pageSize_) || (address + byteCount) > pageSize_)
+    if ((address >= pageSize_) || byteCount > (pageSize_ - address))
     {
         return FramI2C::ResultCode::PageSizeRangeError;
     }    
 
-    uint8_t pageI2cAddress = i2cAddress_ + page;
+    return fillPage(i2cAddress_ + page, address, byteCount, value);
+}
+
+
+FramI2C::ResultCode FramI2C::fillPage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, const uint8_t value) const
+{
+    // Fills byteCount bytes of the FRAM page at pageI2cAddress with value. Parameters are not checked.
+
+    uint8_t valueBuffer[PatternBufferSize];
+    size_t valueBufferSize = (byteCount < PatternBufferSize) ? byteCount : PatternBufferSize;
+    memset(valueBuffer, value, valueBufferSize);
+    size_t cycleOffset = 0;
+    return fillPagePattern(pageI2cAddress, address, byteCount, valueBuffer, valueBufferSize, cycleOffset);
+}
+
+
+FramI2C::ResultCode FramI2C::fillPagePattern(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+    const uint8_t* const cycle, const size_t cycleSize, size_t& cycleOffset) const
+{
+    // Fills byteCount bytes of the FRAM page at pageI2cAddress with the repeating cycle, starting at
+    // cycleOffset in cycle. cycleOffset is advanced past the bytes written. Parameters are not checked.
+
+    notifyWriteObserver(pageI2cAddress, address, byteCount);
+
     uint16_t framChunkAddress = address;
     size_t totalBytesRemaining = byteCount;
-    size_t i2cBufferUsableLength = I2CBufferLength - addressBytesCount_;
+    size_t i2cBufferUsableLength = i2cBufferLength_ - addressBytesCount_;
     size_t bytesQueued = 0;
     ResultCode resultcode = ResultCode::Success;
 
@@ -401,17 +1134,23 @@ FramI2C::ResultCode FramI2C::fill(const uint8_t page, const uint16_t address, co
         size_t chunkSize = (totalBytesRemaining > i2cBufferUsableLength) ? i2cBufferUsableLength : totalBytesRemaining;
         
         bytesQueued = 0;
-        Wire.beginTransmission(pageI2cAddress);
+        bus_->beginTransmission(pageI2cAddress);
         if (addressBytesCount_ > 1)
         {
-            bytesQueued += Wire.write(framChunkAddress >> 8);   //MSB
+            bytesQueued += bus_->write(framChunkAddress >> 8);   //MSB
         }
-        bytesQueued += Wire.write(framChunkAddress & 0xFF);     //LSB
+        bytesQueued += bus_->write(framChunkAddress & 0xFF);     //LSB
         
-        // Write chunkSize values to I2C buffer.      
-        for (size_t i = 0; i < chunkSize; ++i)
+        // Queue chunkSize bytes of the cycle in as few pieces as possible.
+        size_t chunkBytesRemaining = chunkSize;
+        while (chunkBytesRemaining > 0)
         {
-            bytesQueued += Wire.write(value);
+            size_t pieceSize = cycleSize - cycleOffset;
+            pieceSize = (pieceSize < chunkBytesRemaining) ? pieceSize : chunkBytesRemaining;
+            bytesQueued += bus_->write(cycle + cycleOffset, pieceSize);
+            cycleOffset += pieceSize;
+            cycleOffset = (cycleOffset == cycleSize) ? 0 : cycleOffset;
+            chunkBytesRemaining -= pieceSize;
         }
         if (bytesQueued != addressBytesCount_ + chunkSize)
         {     
@@ -419,8 +1158,8 @@ FramI2C::ResultCode FramI2C::fill(const uint8_t page, const uint16_t address, co
         }  
 
         // Transmit I2C buffer to FRAM.
-        uint8_t twiresult = Wire.endTransmission();
-        if (twiresult != TwiSuccess)
+        uint8_t twiresult = bus_->endTransmission(true);
+        if (twiresult != FramI2CBus::TwiSuccess)
         {
             return twiCodeToResultCode(twiresult);
         }
@@ -440,30 +1179,36 @@ bool FramI2C::getDeviceId(void) const
 {
     // Reads the device id (if the FRAM that is used supports it).
 
+    if (bus_ == nullptr)
+    {
+        return false;
+    }
+    deviceIdChecked_ = true;
+
     const uint8_t reservedSlaveAddress = 0x7C;  // See datasheets for information.
     const size_t deviceIdSize = 3;
     uint8_t deviceId[3];
 
     size_t bytesQueued = 0;
-    Wire.beginTransmission(reservedSlaveAddress);
-    bytesQueued += Wire.write(i2cAddress_ << 1);
+    bus_->beginTransmission(reservedSlaveAddress);
+    bytesQueued += bus_->write(i2cAddress_ << 1);
     if (bytesQueued != 1)
     {
         return false;
     }  
-    uint8_t twiresult = Wire.endTransmission(false);
-    if (twiresult != TwiSuccess)
+    uint8_t twiresult = bus_->endTransmission(false);
+    if (twiresult != FramI2CBus::TwiSuccess)
     {
         return false;
     }
 
-    size_t bytesRead = Wire.requestFrom(reservedSlaveAddress, deviceIdSize, true);       
+    size_t bytesRead = bus_->requestFrom(reservedSlaveAddress, deviceIdSize, true);       
     if (bytesRead != deviceIdSize)
     {
         return false;
     }
 
-    if (Wire.readBytes(deviceId, deviceIdSize) != deviceIdSize)
+    if (bus_->readBytes(deviceId, deviceIdSize) != deviceIdSize)
     {
         return false;
     }
@@ -479,67 +1224,222 @@ bool FramI2C::getDeviceId(void) const
     // Product ID = Device ID bits 11-0.
     productId_ = (static_cast<uint16_t>(deviceId[1] & 0x0F) << 8) | deviceId[2];
 
-    // uint8_t densityCode = deviceId[1] & 0x0F;
+    // The density code (bits 11-8) is the upper nibble of the product ID, see deviceIdToDensity().
     
     return true;
 }
 
 // --- Private ----------------------------------------------------------------
 
-// The last element 0 denotes the end of the array, 0 is not a supported density.
-const uint16_t FramI2C::SupportedDensitiesInKiloBits[] = {4, 16, 64, 128, 256, 512, 1024, 0}; 
+uint16_t FramI2C::detectDensity(void) const
+{
+    // Returns the density of the chip at i2cAddress_, 0 if it cannot be determined.
+    // Chips that support a device ID are identified by manufacturer and density code,
+    // chips without device ID are probed (see probeDensity()).
+
+    if (getDeviceId())
+    {
+        return deviceIdToDensity(manufacturerId_, productId_);
+    }
+    return probeDensity();
+}
 
 
-size_t FramI2C::densityToMemorySize(const uint16_t density) const
+uint16_t FramI2C::deviceIdToDensity(const uint16_t manufacturerId, const uint16_t productId)
 {
-    if (!isDensitySupported(density))
-    {
-        return 0;
-    } 
+    // Density of a chip with device ID, 0 for unknown manufacturers and density codes.
+    // Density codes per manufacturer, indexed by code (0 = not used):
+    //   Cypress  (0x004): FM24V01 (1), FM24V02 (2), FM24V05 (3), FM24V10 (4).
+    //   Fujitsu  (0x00A): MB85RC04V (0), MB85RC64TA (3), MB85RC128A (4), MB85RC256V (5), MB85RC512T (6), MB85RC1MT (7).
+
+    static const uint16_t cypressDensities[] = {0, 128, 256, 512, 1024};
+    static const uint16_t fujitsuDensities[] = {4, 0, 0, 64, 128, 256, 512, 1024};
+    const uint8_t densityCode = (productId >> 8) & 0x0F;
 
-    size_t memorySize = density * 1024 / 8;
-    return memorySize;
+    if (manufacturerId == 0x004 && densityCode < sizeof(cypressDensities) / sizeof(cypressDensities[0]))
+    {
+        return cypressDensities[densityCode];
+    }
+    if (manufacturerId == 0x00A && densityCode < sizeof(fujitsuDensities) / sizeof(fujitsuDensities[0]))
+    {
+        return fujitsuDensities[densityCode];
+    }
+    return 0;
 }
 
 
-size_t FramI2C::densityToPageSize(const uint16_t density) const
+uint16_t FramI2C::probeDensity(void) const
 {
-    if (!isDensitySupported(density))
+    // Determines the density of a chip without device ID, 0 if no chip responds.
+    // Chips with 8-bit addressing have multiple pages on consecutive I2C addresses: 16 kb chips respond
+    // on all of 0x50 - 0x57, 4 kb chips on an even I2C address and the next. Separate chips with 16-bit
+    // addressing on consecutive I2C addresses also respond on multiple addresses, therefore 8-bit
+    // addressing is confirmed first (probeByteAddressing()), otherwise the density is not determined.
+    // (1 Mb chips also use two I2C addresses but always support the device ID.)
+    // For chips on a single I2C address (16-bit addressing) the memory size is found via address wrap-around:
+    // chips ignore address bits above their memory size, so address size is an alias of address 0 if the
+    // memory size is size. A byte that is changed for this check is restored immediately, memory contents
+    // are therefore preserved (unless power fails during the probe). Write protected chips cannot be sized
+    // this way and are not determined.
+
+    if (!probeAddress(i2cAddress_))
     {
         return 0;
     }
-
-    size_t pageSize = 0;  
-    if (density <= 16)
+    uint8_t respondingCount = 1;
+    while (respondingCount < 8 && i2cAddress_ + respondingCount <= 0x7F && probeAddress(i2cAddress_ + respondingCount))
+    {
+        ++respondingCount;
+    }
+    if (respondingCount > 1)
     {
-        pageSize = 0x100;   // Densities 4 and 16.
+        if (!probeByteAddressing())
+        {
+            return 0;
+        }
+        return (respondingCount == 8 && i2cAddress_ == 0x50) ? 16 : (((i2cAddress_ & 0x01) == 0) ? 4 : 0);
     }
-    else if (density <= 256)
+
+    uint8_t value0;
+    if (!probeRead(0, value0))
     {
-        pageSize = densityToMemorySize(density);  // Densities 64, 128 and 256.      
+        return 0;
     }
-    else
-    {  
-        pageSize = 0x10000;  // Densities 512 and 1024.         
+    for (uint32_t size = 0x2000; size < 0x10000; size <<= 1)
+    {
+        // Memory sizes of 64, 128 and 256 kb.
+        uint8_t value;
+        if (!probeRead(size, value))
+        {
+            return 0;
+        }
+        if (value != value0)
+        {
+            // Different contents, address size is not an alias of address 0.
+            continue;
+        }
+        const uint8_t marker = ~value0;
+        uint8_t written = value0;
+        uint8_t check = value0;
+        bool ok = probeWrite(size, marker) && probeRead(size, written) && probeRead(0, check);
+        ok = probeWrite(size, value0) && ok;   // Restore (address size and 0 both held value0).
+        if (!ok || written != marker)
+        {
+            // Bus error, or the marker was acknowledged but not stored (write protected chip).
+            return 0;
+        }
+        if (check == marker)
+        {
+            return size / 128;
+        }
     }
-    return pageSize;
+    return 512;     // No alias below 64 kB.
 }
 
 
-bool FramI2C::isDensitySupported(const uint16_t densityInKiloBits) const
+bool FramI2C::probeByteAddressing(void) const
 {
-    bool isSupported = false;
-    uint8_t i = 0;
-    while (FramI2C::SupportedDensitiesInKiloBits[i] != 0)
+    // True if the chip at i2cAddress_ uses 8-bit addressing.
+    // A 2 byte write {0x00, marker} stores marker at address 0 of a chip with 8-bit addressing, while a
+    // chip with 16-bit addressing only sets its address (to marker) and stores nothing. Reading 2 bytes
+    // from address 0 with an 8-bit address must then return the marker followed by the unchanged byte at
+    // address 1. This is checked with two different markers, address 0 is restored afterwards.
+    // The probe is safe for both kinds of chips: a chip with 16-bit addressing never receives data bytes.
+
+    const uint8_t address0 = 0x00;
+    uint8_t original[2];
+    if (!probeTransmit(&address0, 1, false) || !probeReceive(original, 2))
     {
-        if (densityInKiloBits == SupportedDensitiesInKiloBits[i])
-        {
-            isSupported = true;
-            break;
-        }
-        ++i;
+        return false;
+    }
+    const uint8_t markers[] = {static_cast<uint8_t>(~original[0]), static_cast<uint8_t>(original[0] ^ 0x5A)};
+    bool byteAddressed = true;
+    for (uint8_t marker : markers)
+    {
+        const uint8_t write[] = {address0, marker};
+        uint8_t check[2];
+        bool ok = probeTransmit(write, 2, true) && probeTransmit(&address0, 1, false) && probeReceive(check, 2);
+        byteAddressed = byteAddressed && ok && check[0] == marker && check[1] == original[1];
     }
-    return isSupported;
+    const uint8_t restore[] = {address0, original[0]};
+    return probeTransmit(restore, 2, true) && byteAddressed;
+}
+
+
+bool FramI2C::probeTransmit(const uint8_t* const data, const size_t byteCount, const bool sendStop) const
+{
+    // Writes byteCount bytes (address and data bytes) to the chip at i2cAddress_.
+
+    bus_->beginTransmission(i2cAddress_);
+    size_t bytesQueued = bus_->write(data, byteCount);
+    return bytesQueued == byteCount && bus_->endTransmission(sendStop) == FramI2CBus::TwiSuccess;
+}
+
+
+bool FramI2C::probeReceive(uint8_t* const data, const size_t byteCount) const
+{
+    // Reads byteCount bytes from the current address of the chip at i2cAddress_.
+
+    return bus_->requestFrom(i2cAddress_, byteCount, true) == byteCount && bus_->readBytes(data, byteCount) == byteCount;
+}
+
+
+bool FramI2C::probeAddress(const uint8_t i2cAddress) const
+{
+    // True if a device acknowledges i2cAddress (address only, no data is written).
+
+    bus_->beginTransmission(i2cAddress);
+    return bus_->endTransmission(true) == FramI2CBus::TwiSuccess;
+}
+
+
+bool FramI2C::probeRead(const uint16_t address, uint8_t& value) const
+{
+    // Reads a single byte with 16-bit addressing.
+
+    const uint8_t write[] = {static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address & 0xFF)};
+    return probeTransmit(write, 2, false) && probeReceive(&value, 1);
+}
+
+
+bool FramI2C::probeWrite(const uint16_t address, const uint8_t value) const
+{
+    // Writes a single byte with 16-bit addressing.
+
+    const uint8_t write[] = {static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address & 0xFF), value};
+    return probeTransmit(write, 3, true);
+}
+
+
+uint32_t FramI2C::densityToMemorySize(const uint16_t density) const
+{
+    // Geometry is shared with the host simulator and image tools (FramI2CGeometry.h).
+    return FramI2CGeometry::memorySize(density);
+}
+
+
+uint32_t FramI2C::densityToPageSize(const uint16_t density) const
+{
+    return FramI2CGeometry::pageSize(density);
+}
+
+
+size_t FramI2C::pageSpan(const uint32_t address, const size_t byteCount, uint8_t& pageI2cAddress, uint16_t& pageAddress) const
+{
+    // Maps linear memory address to the page's I2C address and the address within the page.
+    // Returns the number of bytes (max byteCount) from address up to the end of the page.
+
+    uint32_t page = address / pageSize_;
+    pageI2cAddress = i2cAddress_ + page;
+    pageAddress = address - page * pageSize_;
+    uint32_t bytesToPageEnd = pageSize_ - pageAddress;
+    return (byteCount < bytesToPageEnd) ? byteCount : static_cast<size_t>(bytesToPageEnd);
+}
+
+
+bool FramI2C::isDensitySupported(const uint16_t densityInKiloBits) const
+{
+    return FramI2CGeometry::isDensitySupported(densityInKiloBits);
 }
 
 
@@ -548,16 +1448,16 @@ FramI2C::ResultCode FramI2C::twiCodeToResultCode(const uint8_t twiCode) const
     ResultCode retval = FramI2C::ResultCode::I2CUnknownTwiResultCode;
     switch (twiCode)
     {
-        case FramI2C::TwiSuccess:
+        case FramI2CBus::TwiSuccess:
             retval = FramI2C::ResultCode::Success;
             break;
-        case FramI2C::TwiAddressNack:
+        case FramI2CBus::TwiAddressNack:
             retval = FramI2C::ResultCode::I2CAddressNackError;
             break;
-        case FramI2C::TwiDataNack:
+        case FramI2CBus::TwiDataNack:
             retval = FramI2C::ResultCode::I2CDataNackError;
             break;
-        case FramI2C::TwiLineBusy:
+        case FramI2CBus::TwiLineBusy:
             retval = FramI2C::ResultCode::I2CLineBusyError;
             break;
     }
@@ -565,4 +1465,67 @@ FramI2C::ResultCode FramI2C::twiCodeToResultCode(const uint8_t twiCode) const
 }
 
 
+FramI2C::ResultCode FramI2C::readElements(const uint32_t address, const size_t elementSize, const size_t elementCount, uint8_t* const data, const FramByteOrder byteOrder) const
+{
+    // Reads elementCount elements of elementSize bytes and converts them from byteOrder in place.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (elementCount > memorySize_ / elementSize)
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    ResultCode resultcode = readBytes(address, elementSize * elementCount, data);
+    if (resultcode == FramI2C::ResultCode::Success && FramI2CEndian::needsSwap(byteOrder))
+    {
+        FramI2CEndian::swap(data, elementSize, elementCount);
+    }
+    return resultcode;
+}
+
+
+FramI2C::ResultCode FramI2C::writeElements(const uint32_t address, const size_t elementSize, const size_t elementCount, const uint8_t* const data, const FramByteOrder byteOrder) const
+{
+    // Writes elementCount elements of elementSize bytes, converted to byteOrder.
+    // Without conversion data is written directly. With conversion the range is validated first,
+    // so that a range error does not leave a partially written range.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (elementCount > memorySize_ / elementSize)
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    const size_t byteCount = elementSize * elementCount;
+    if (!FramI2CEndian::needsSwap(byteOrder))
+    {
+        return writeBytes(address, byteCount, data);
+    }
+
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    return FramI2CEndian::writeSwapped(*this, address, elementSize, elementCount, data, i2cBufferLength_ - addressBytesCount_);
+}
+
+
+void FramI2C::notifyWriteObserver(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount) const
+{
+    if (writeObserver_ != nullptr)
+    {
+        uint32_t linearAddress = static_cast<uint32_t>(pageI2cAddress - i2cAddress_) * pageSize_ + address;
+        writeObserver_->framWritten(linearAddress, byteCount);
+    }
+}
+
+
 /* eof */
@@ -13,33 +13,59 @@
 #ifndef FRAMI2C_H_
 #define FRAMI2C_H_
 
+#if defined(ARDUINO)
 #include <Arduino.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+#include "FramI2CBus.h"
+#include "FramI2CCrc.h"
+#include "FramI2CEndian.h"
+#include "FramI2CGeometry.h"
+
+
+// Segment of a scatter read (readv) or gather write (writev).
+struct FramI2CReadSegment
+{
+    uint8_t* data;
+    size_t byteCount;
+};
 
+struct FramI2CWriteSegment
+{
+    const uint8_t* data;
+    size_t byteCount;
+};
 
-class FramI2C 
+
+class FramI2CWriteObserver
 {
+    // Interface for objects that must be notified of writes to FRAM (e.g. a read cache).
+    // framWritten() is called before the FRAM memory at linear address..address + byteCount - 1
+    // is written or filled, also when the write subsequently fails.
 
-private:
-    // Values returned by Wire library
-    enum TwiResultCode
-    {
-        TwiSuccess = 0,
-        TwiBufferOverflow = 1,
-        TwiAddressNack = 2,
-        TwiDataNack = 3,
-        TwiLineBusy = 4        
-    };
+public:
 
+    virtual ~FramI2CWriteObserver() {}
+    virtual void framWritten(const uint32_t address, const size_t byteCount) = 0;
+};
+
+
+class FramI2C 
+{
 
 public:
 
     enum class ResultCode : uint8_t 
     {
         Success = 0, 
-        I2CBufferOverflowError = TwiBufferOverflow, 
-        I2CAddressNackError = TwiAddressNack,
-        I2CDataNackError = TwiDataNack, 
-        I2CLineBusyError = TwiLineBusy,
+        I2CBufferOverflowError = FramI2CBus::TwiBufferOverflow, 
+        I2CAddressNackError = FramI2CBus::TwiAddressNack,
+        I2CDataNackError = FramI2CBus::TwiDataNack, 
+        I2CLineBusyError = FramI2CBus::TwiLineBusy,
         I2CReadError = 0xC0,
         I2CWriteError = 0xC1,
         I2CUnknownTwiResultCode = 0xC2,
@@ -51,36 +77,92 @@ public:
         PageSizeRangeError = 0xE5,
         BufferAllocationFailedError = 0xE6, 
         BufferOverflowError = 0xE7,
+        I2CBufferLengthError = 0xE8,
+        MemoryRangeError = 0xE9,
+        InvalidChipCountError = 0xEA,
+        QueueFullError = 0xEB,
+        VerifyError = 0xEC,
+        TransferError = 0xED,
+        DensityDetectionError = 0xEE,
         Uninitialized = 0xFF
     };
 
+    // Density parameter for begin(): density and geometry are detected from the chip (see detectDensity()).
+    static const uint16_t AutoDetectDensity = 0;
+
     FramI2C();
     ~FramI2C();
 
-	ResultCode begin(const uint16_t densityInKiloBits, const uint8_t i2cAddress = DefaultI2CAddress, const size_t typebufferSize = DefaultTypeBufferSize);
+#if defined(ARDUINO)
+	ResultCode begin(const uint16_t densityInKiloBits, const uint8_t i2cAddress = DefaultI2CAddress, const size_t typebufferSize = DefaultTypeBufferSize, const size_t i2cBufferLength = 0);
+#endif
+	ResultCode begin(FramI2CBus& bus, const uint16_t densityInKiloBits, const uint8_t i2cAddress = DefaultI2CAddress, const size_t typebufferSize = DefaultTypeBufferSize, const size_t i2cBufferLength = 0);
 	void end(void);
 
     uint16_t density(void) const;
     uint8_t i2cAddress(void) const;
-    size_t memorySize(void) const;
+    uint32_t memorySize(void) const;
     uint8_t addressBytesCount(void) const;
-    size_t pageSize(void) const;
+    uint32_t pageSize(void) const;
     uint8_t pageCount(void) const;
-    size_t typebufferSize(void) const; 
+    size_t typebufferSize(void) const;     // Deprecated, always 0.
+    size_t i2cBufferLength(void) const;
     bool isInitialized(void) const;
     bool isDeviceIdSupported(void) const;
     uint16_t manufacturerId(void) const;
     uint16_t productId(void) const;
 
-    ResultCode readBytes(const uint16_t address, const size_t byteCount, uint8_t* const data) const;
+    bool streamingRead(void) const;
+    void setStreamingRead(const bool enabled);
+
+    bool writeVerify(void) const;
+    void setWriteVerify(const bool enabled);
+
+    // Only a single observer is supported, nullptr removes the observer.
+    FramI2CWriteObserver* writeObserver(void) const;
+    void setWriteObserver(FramI2CWriteObserver* const observer);
+
+    // Overloads without page parameter use linear addressing: address 0 to memorySize() - 1,
+    // transfers that cross page boundaries are split automatically.
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data) const;
     ResultCode readBytes(const uint8_t page, const uint16_t address, const size_t byteCount, uint8_t* const data) const;       
 
-    ResultCode writeBytes(const uint16_t address, const size_t byteCount, const uint8_t* const data) const;
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data) const;
     ResultCode writeBytes(const uint8_t page, const uint16_t address, const size_t byteCount, const uint8_t* const data) const;
 
-    ResultCode fill(const uint16_t address, const size_t byteCount, const uint8_t value) const;
+    ResultCode fill(const uint32_t address, const size_t byteCount, const uint8_t value) const;
+
     ResultCode fill(const uint8_t page, const uint16_t address, const size_t byteCount, const uint8_t value) const;
 
+    // Fills a range with a repeating multi-byte pattern (e.g. 0xDEADBEEF or a struct), see also fillArray().
+    ResultCode fillPattern(const uint32_t address, const size_t byteCount, const uint8_t* const pattern, const size_t patternSize) const;
+
+    // Fills the complete memory with value.
+    ResultCode erase(const uint8_t value = 0x00) const;
+
+    // Compares FRAM with expected without reading into a full-size buffer. Returns VerifyError on the first
+    // difference, mismatchOffset is set to its offset from address (byteCount if all bytes are equal).
+    ResultCode compare(const uint32_t address, const size_t byteCount, const uint8_t* const expected, size_t& mismatchOffset) const;
+    ResultCode compare(const uint8_t page, const uint16_t address, const size_t byteCount, const uint8_t* const expected, size_t& mismatchOffset) const;
+
+    // Computes the CRC of a FRAM range. Data is fed from the I2C buffer into the CRC engine
+    // chunk by chunk, the range is not read into RAM. See FramI2CCrc.h for the algorithms.
+    ResultCode checksum(const uint32_t address, const size_t byteCount, const FramCrcAlgorithm algorithm, uint32_t& crc) const;
+    ResultCode checksum(const uint8_t page, const uint16_t address, const size_t byteCount, const FramCrcAlgorithm algorithm, uint32_t& crc) const;
+
+    // Copies a range within the same chip (memmove semantics: source and destination may overlap).
+    ResultCode copy(const uint32_t sourceAddress, const uint32_t destinationAddress, const size_t byteCount) const;
+    ResultCode copy(const uint8_t sourcePage, const uint16_t sourceAddress,
+        const uint8_t destinationPage, const uint16_t destinationAddress, const size_t byteCount) const;
+
+    // Copies a range from one chip to another (linear addressing), chunk by chunk through a small internal buffer.
+    static ResultCode copy(const FramI2C& source, const uint32_t sourceAddress,
+        const FramI2C& destination, const uint32_t destinationAddress, const size_t byteCount);
+
+    // Scatter read / gather write: one contiguous FRAM range (linear addressing) from/to multiple buffers.
+    ResultCode readv(const uint32_t address, const FramI2CReadSegment* const segments, const size_t segmentCount) const;
+    ResultCode writev(const uint32_t address, const FramI2CWriteSegment* const segments, const size_t segmentCount) const;
+
     // ResultCode sleep(void) const;
 
 
@@ -88,31 +170,24 @@ public:
     {
         // Generic read method.
         // Sets value of output parameter t to value read from FRAM(page, address).
-        // If the read fails t is unchanged.
-        // With the default type buffer size (10) read() can be used for integral and floating point types.
-        // For use with other, larger types the type buffer size must be increased to at least sizeof(t). 
+        // Data is read directly into t (no intermediate buffer), T can be any trivially copyable type
+        // of any size (e.g. integral and floating point types, structs and arrays of these).
+        // If the read fails t may be partially modified.
         // Example usage:
         //   double storedTemperature = 0.0;
         //   read(0, 0, storedTemperature);      
 
-        if (sizeof(T) > typebufferSize_)
-        {
-            return FramI2C::ResultCode::BufferOverflowError;
-        }  
-
-        ResultCode resultcode = readBytes(page, address, sizeof(T), typebuffer_);
-        if (resultcode == FramI2C::ResultCode::Success)
-        {
-            memcpy((uint8_t*) &t, typebuffer_, sizeof(T));
-        }
-        return resultcode;
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        return readBytes(page, address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
     }    
 
 
-    template<typename T> ResultCode read(const uint16_t address, const T& t) 
+    template<typename T> ResultCode read(const uint32_t address, T& t) 
     {
-        // Overload without page parameter, uses page 0.
-        return read(0, address, t);
+        // Overload without page parameter, uses linear address.
+
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        return readBytes(address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
     }        
 
 
@@ -120,56 +195,202 @@ public:
     {
         // Generic write method.
         // Writes input parameter t's value to FRAM(page, address).
-        // With the default type buffer size (10) write() can be used for integral and floating point types.
-        // For use with other, larger types the type buffer size must be increased to at least sizeof(t). 
+        // Data is written directly from t (no intermediate buffer), T can be any trivially copyable type.
         // Example usage:
         //   double temperature = 21.3;
         //   write(0, 0, temperature);        
 
-        if (sizeof(T) > typebufferSize_)
-        {
-            return FramI2C::ResultCode::BufferOverflowError;
-        }
-
-        memcpy(typebuffer_, (const uint8_t*)&t, sizeof(T));
-        return writeBytes(page, address, sizeof(T), typebuffer_);
+        static_assert(__is_trivially_copyable(T), "write() requires a trivially copyable type");
+        return writeBytes(page, address, sizeof(T), reinterpret_cast<const uint8_t*>(&t));
     }    
 
 
-    template<typename T> ResultCode write(const uint16_t address, const T& t) 
+    template<typename T> ResultCode write(const uint32_t address, const T& t) 
     {
-        // Overload without page parameter, uses page 0.
-        return write(0, address, t);
+        // Overload without page parameter, uses linear address.
+
+        static_assert(__is_trivially_copyable(T), "write() requires a trivially copyable type");
+        return writeBytes(address, sizeof(T), reinterpret_cast<const uint8_t*>(&t));
     }    
 
 
+    template<typename T> ResultCode readArray(const uint32_t address, T* const elements, const size_t elementCount) const
+    {
+        // Reads elementCount elements of type T starting at linear address into elements.
+        // All elements are transferred with maximum size I2C chunks, not one transaction per element.
+        // Example usage:
+        //   float samples[512];
+        //   readArray(0x100, samples, 512);
+
+        static_assert(__is_trivially_copyable(T), "readArray() requires a trivially copyable type");
+        return readElements(address, sizeof(T), elementCount, reinterpret_cast<uint8_t*>(elements), FramByteOrder::Native);
+    }
+
+
+    template<typename T> ResultCode readArray(const uint32_t address, T* const elements, const size_t elementCount, const FramByteOrder byteOrder) const
+    {
+        // Overload that converts the elements from byteOrder (as stored in FRAM) to the platform's byte order.
+
+        static_assert(__is_trivially_copyable(T), "readArray() requires a trivially copyable type");
+        static_assert(FramByteOrderType<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+            "Byte order conversion requires an integral or floating point type");
+        return readElements(address, sizeof(T), elementCount, reinterpret_cast<uint8_t*>(elements), byteOrder);
+    }
+
+
+    template<typename T> ResultCode writeArray(const uint32_t address, const T* const elements, const size_t elementCount) const
+    {
+        // Writes elementCount elements of type T from elements starting at linear address.
+
+        static_assert(__is_trivially_copyable(T), "writeArray() requires a trivially copyable type");
+        return writeElements(address, sizeof(T), elementCount, reinterpret_cast<const uint8_t*>(elements), FramByteOrder::Native);
+    }
+
+
+    template<typename T> ResultCode writeArray(const uint32_t address, const T* const elements, const size_t elementCount, const FramByteOrder byteOrder) const
+    {
+        // Overload that stores the elements in FRAM in byteOrder. elements is not modified.
+
+        static_assert(__is_trivially_copyable(T), "writeArray() requires a trivially copyable type");
+        static_assert(FramByteOrderType<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+            "Byte order conversion requires an integral or floating point type");
+        return writeElements(address, sizeof(T), elementCount, reinterpret_cast<const uint8_t*>(elements), byteOrder);
+    }
+
+
+    template<typename T> ResultCode fillArray(const uint32_t address, const size_t elementCount, const T& value) const
+    {
+        // Fills elementCount consecutive elements of type T starting at linear address with value.
+        // Example usage:
+        //   Sample empty = {0, -1.0f};
+        //   fillArray(0x100, 64, empty);
+
+        static_assert(__is_trivially_copyable(T), "fillArray() requires a trivially copyable type");
+        if (initialized_ && elementCount > memorySize_ / sizeof(T))
+        {
+            return FramI2C::ResultCode::MemoryRangeError;
+        }
+        return fillPattern(address, elementCount * sizeof(T), reinterpret_cast<const uint8_t*>(&value), sizeof(T));
+    }
+
+
 private:
 
+    friend class FramArray;
+    friend class FramStripe;
+    friend class FramI2CAsync;
+    template<uint16_t DensityInKiloBits, uint8_t BaseI2CAddress> friend class FramI2CFixed;
+
     static const uint8_t DefaultI2CAddress = 0x50;
-    // A 10 byte type buffer is sufficient for all integral and floating point types (max 8 bytes).
+    // The type buffer is no longer used, the typebufferSize parameter of begin() is only kept for compatibility.
     static const size_t DefaultTypeBufferSize = 10;
-    static const size_t I2CBufferLength = 32;   // Hardcoded in Arduino Wire library.
-    static const uint16_t SupportedDensitiesInKiloBits[];
+    // Sizes of the stack buffers in which fill patterns are repeated and copied, compared or checksummed data is transferred.
+#if defined(__AVR__)
+    static const size_t PatternBufferSize = 32;
+    static const size_t TransferBufferSize = 32;
+#else
+    static const size_t PatternBufferSize = 128;
+    static const size_t TransferBufferSize = 128;
+#endif
+
+    class PageChunkSink
+    {
+        // Receives the chunks read by readPageChunks(): copies, compares or checksums them.
+
+    public:
+
+        // Takes chunkSize bytes of the chunk at chunkOffset (relative to the start of the read)
+        // from the bus' receive buffer. Anything other than Success stops the read and is returned.
+        virtual ResultCode takeChunk(FramI2CBus& bus, const size_t chunkOffset, const size_t chunkSize) = 0;
 
+    protected:
+
+        ~PageChunkSink() {}
+    };
+
+    FramI2CBus* bus_ = nullptr;
     uint16_t density_ = 0;
     uint8_t i2cAddress_ = 0;
-    size_t memorySize_ = 0;
-    size_t pageSize_ = 0;
+    uint32_t memorySize_ = 0;     // uint32_t: 512 kb and 1 Mb chips do not fit a 16-bit size_t (AVR).
+    uint32_t pageSize_ = 0;
     uint8_t pageCount_ = 0;
     uint8_t addressBytesCount_ = 0;
-    size_t typebufferSize_ = 0;
-    uint8_t* typebuffer_ = nullptr;
+    size_t i2cBufferLength_ = 0;
     
+    bool streamingRead_ = true;
+    bool writeVerify_ = false;
+    FramI2CWriteObserver* writeObserver_ = nullptr;
     bool initialized_ = false;
     mutable bool deviceIdChecked_ = false;
     mutable bool deviceIdSupported_ = false;
     mutable uint16_t manufacturerId_ = 0;
     mutable uint16_t productId_ = 0;
 
-    size_t densityToMemorySize(const uint16_t densityInKiloBits) const;
-    size_t densityToPageSize(const uint16_t density) const;
+    uint32_t densityToMemorySize(const uint16_t densityInKiloBits) const;
+    uint32_t densityToPageSize(const uint16_t density) const;
     bool getDeviceId(void) const;    
+    uint16_t detectDensity(void) const;
+    static uint16_t deviceIdToDensity(const uint16_t manufacturerId, const uint16_t productId);
+    uint16_t probeDensity(void) const;
+    bool probeByteAddressing(void) const;
+    bool probeTransmit(const uint8_t* const data, const size_t byteCount, const bool sendStop) const;
+    bool probeReceive(uint8_t* const data, const size_t byteCount) const;
+    bool probeAddress(const uint8_t i2cAddress) const;
+    bool probeRead(const uint16_t address, uint8_t& value) const;
+    bool probeWrite(const uint16_t address, const uint8_t value) const;
     bool isDensitySupported(const uint16_t densityInKiloBits) const;
+    size_t pageSpan(const uint32_t address, const size_t byteCount, uint8_t& pageI2cAddress, uint16_t& pageAddress) const;
+    ResultCode readPage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, uint8_t* const data) const;
+    ResultCode writePage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, const uint8_t* const data) const;
+    ResultCode fillPage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, const uint8_t value) const;
+    ResultCode fillPagePattern(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+        const uint8_t* const cycle, const size_t cycleSize, size_t& cycleOffset) const;
+    ResultCode readPageChunks(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, PageChunkSink& sink) const;
+    ResultCode readPageSegments(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+        const FramI2CReadSegment*& segment, size_t& segmentOffset) const;
+    ResultCode comparePageSegments(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+        const FramI2CWriteSegment*& segment, size_t& segmentOffset, size_t& mismatchOffset) const;
+    ResultCode checksumPage(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount, FramI2CCrc& crc) const;
+    ResultCode writePageSegments(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount,
+        const FramI2CWriteSegment*& segment, size_t& segmentOffset) const;
+
+
+    template<typename Segment> ResultCode checkSegments(const uint32_t address, const Segment* const segments, 
+        const size_t segmentCount, size_t& byteCount) const
+    {
+        // Validates the segments and the FRAM range they cover, returns the total size in byteCount.
+
+        if (!initialized_)
+        {
+            return FramI2C::ResultCode::NotInitializedError;
+        }
+        if (segments == nullptr)
+        {
+            return FramI2C::ResultCode::NullPtrError;
+        }
+        byteCount = 0;
+        for (size_t i = 0; i < segmentCount; ++i)
+        {
+            if (segments[i].data == nullptr && segments[i].byteCount > 0)
+            {
+                return FramI2C::ResultCode::NullPtrError;
+            }
+            if (segments[i].byteCount > memorySize_ - byteCount)
+            {
+                return FramI2C::ResultCode::MemoryRangeError;
+            }
+            byteCount += segments[i].byteCount;
+        }
+        if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+        {
+            return FramI2C::ResultCode::MemoryRangeError;
+        }
+        return FramI2C::ResultCode::Success;
+    }
+
+    ResultCode readElements(const uint32_t address, const size_t elementSize, const size_t elementCount, uint8_t* const data, const FramByteOrder byteOrder) const;
+    ResultCode writeElements(const uint32_t address, const size_t elementSize, const size_t elementCount, const uint8_t* const data, const FramByteOrder byteOrder) const;
+    void notifyWriteObserver(const uint8_t pageI2cAddress, const uint16_t address, const size_t byteCount) const;
     ResultCode twiCodeToResultCode(const uint8_t twiCode) const;
 };
 
@@ -0,0 +1,234 @@
+/* FramI2CAsync.cpp
+ *
+ * Description:  Non-blocking FRAM transfers for FramI2C, advanced one I2C chunk per poll().
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramI2CAsync.h"
+
+
+// --- Public -----------------------------------------------------------------
+
+FramI2CAsync::FramI2CAsync()
+{
+    // Empty. All initialization is done in begin().
+}
+
+
+FramI2CAsync::~FramI2CAsync()
+{
+    end();
+}
+
+
+FramI2CAsync::ResultCode FramI2CAsync::begin(FramI2C& fram, const uint8_t queueLength, const size_t maxChunkSize)
+{
+    if (initialized_)
+    {
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (!fram.isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (queueLength == 0)
+    {
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    queue_ = static_cast<Request*>(malloc(queueLength * sizeof(Request)));
+    if (queue_ == nullptr)
+    {
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    fram_ = &fram;
+    queueLength_ = queueLength;
+    head_ = 0;
+    count_ = 0;
+    maxChunkSize_ = maxChunkSize;
+    initialized_ = true;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+void FramI2CAsync::end(void)
+{
+    free(queue_);
+    queue_ = nullptr;
+    fram_ = nullptr;
+    queueLength_ = 0;
+    head_ = 0;
+    count_ = 0;
+    initialized_ = false;
+}
+
+
+bool FramI2CAsync::isInitialized(void) const
+{
+    return initialized_;
+}
+
+
+bool FramI2CAsync::isBusy(void) const
+{
+    return count_ > 0;
+}
+
+
+uint8_t FramI2CAsync::pendingCount(void) const
+{
+    return count_;
+}
+
+
+FramI2CAsync::ResultCode FramI2CAsync::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data,
+    const CompletionCallback callback, void* const context)
+{
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    return enqueue(Operation::Read, address, byteCount, data, 0, callback, context);
+}
+
+
+FramI2CAsync::ResultCode FramI2CAsync::writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data,
+    const CompletionCallback callback, void* const context)
+{
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    // data is only read from for Operation::Write.
+    return enqueue(Operation::Write, address, byteCount, const_cast<uint8_t*>(data), 0, callback, context);
+}
+
+
+FramI2CAsync::ResultCode FramI2CAsync::fill(const uint32_t address, const size_t byteCount, const uint8_t value,
+    const CompletionCallback callback, void* const context)
+{
+    return enqueue(Operation::Fill, address, byteCount, nullptr, value, callback, context);
+}
+
+
+FramI2CAsync::ResultCode FramI2CAsync::poll(void)
+{
+    // A chunk never crosses a page boundary and is at most one I2C buffer (minus the FRAM address
+    // bytes for writes), so every step is a single I2C write transaction, or an address write
+    // followed by a single read. The FRAM address is set for every read chunk (no streaming read)
+    // because other code may access the chip in between poll() calls.
+
+    if (!initialized_ || count_ == 0)
+    {
+        return FramI2C::ResultCode::Success;
+    }
+
+    Request& request = queue_[head_];
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    if (!fram_->isInitialized())
+    {
+        // The FramI2C instance was end()ed while requests are pending: complete the request with an error.
+        resultcode = FramI2C::ResultCode::NotInitializedError;
+    }
+    else
+    {
+        size_t chunkLimit = (request.operation == Operation::Read)
+            ? fram_->i2cBufferLength()
+            : fram_->i2cBufferLength() - fram_->addressBytesCount();
+        if (maxChunkSize_ > 0 && maxChunkSize_ < chunkLimit)
+        {
+            chunkLimit = maxChunkSize_;
+        }
+
+        uint8_t pageI2cAddress;
+        uint16_t pageAddress;
+        size_t totalBytesRemaining = request.byteCount - request.bytesDone;
+        size_t chunkSize = fram_->pageSpan(request.address + request.bytesDone, totalBytesRemaining, pageI2cAddress, pageAddress);
+        chunkSize = (chunkSize < chunkLimit) ? chunkSize : chunkLimit;
+
+        switch (request.operation)
+        {
+            case Operation::Read:
+                resultcode = fram_->readPage(pageI2cAddress, pageAddress, chunkSize, request.data + request.bytesDone);
+                break;
+            case Operation::Write:
+                resultcode = fram_->writePage(pageI2cAddress, pageAddress, chunkSize, request.data + request.bytesDone);
+                break;
+            case Operation::Fill:
+                resultcode = fram_->fillPage(pageI2cAddress, pageAddress, chunkSize, request.value);
+                break;
+        }
+        request.bytesDone += chunkSize;
+    }
+
+    if (resultcode != FramI2C::ResultCode::Success || request.bytesDone == request.byteCount)
+    {
+        // Remove the request before calling the callback, so that the callback can queue a new request.
+        CompletionCallback callback = request.callback;
+        void* context = request.context;
+        head_ = (head_ + 1) % queueLength_;
+        --count_;
+        if (callback != nullptr)
+        {
+            callback(resultcode, context);
+        }
+    }
+    return resultcode;
+}
+
+
+FramI2CAsync::ResultCode FramI2CAsync::waitAll(void)
+{
+    // Returns the first error (the remaining requests are still completed).
+    ResultCode firstError = FramI2C::ResultCode::Success;
+    while (count_ > 0)
+    {
+        ResultCode resultcode = poll();
+        if (firstError == FramI2C::ResultCode::Success)
+        {
+            firstError = resultcode;
+        }
+    }
+    return firstError;
+}
+
+
+// --- Private ----------------------------------------------------------------
+
+FramI2CAsync::ResultCode FramI2CAsync::enqueue(const Operation operation, const uint32_t address, const size_t byteCount, uint8_t* const data,
+    const uint8_t value, const CompletionCallback callback, void* const context)
+{
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((address >= fram_->memorySize()) || byteCount > (fram_->memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    if (count_ == queueLength_)
+    {
+        return FramI2C::ResultCode::QueueFullError;
+    }
+
+    Request& request = queue_[(head_ + count_) % queueLength_];
+    request.operation = operation;
+    request.address = address;
+    request.byteCount = byteCount;
+    request.bytesDone = 0;
+    request.data = data;
+    request.value = value;
+    request.callback = callback;
+    request.context = context;
+    ++count_;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+/* eof */
@@ -0,0 +1,106 @@
+/* FramI2CAsync.h
+ *
+ * Description:  Non-blocking FRAM transfers for FramI2C.
+ *               readBytes(), writeBytes() and fill() queue a request and return immediately.
+ *               Each call to poll() performs a single I2C chunk of the oldest request, so a large
+ *               transfer is spread over many poll() calls and the caller is never blocked for longer
+ *               than one chunk. When a request is completed (or fails) its callback is called
+ *               with the ResultCode.
+ *
+ *               The data buffers passed to readBytes() and writeBytes() must remain valid
+ *               until the request's callback has been called.
+ *
+ *               Example usage:
+ *                 FramI2CAsync framAsync;
+ *                 framAsync.begin(fram);
+ *                 framAsync.writeBytes(0, sizeof(log), log, logWritten);
+ *                 ...
+ *                 void loop()     // 1 ms tick
+ *                 {
+ *                     control();
+ *                     framAsync.poll();
+ *                 }
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CASYNC_H_
+#define FRAMI2CASYNC_H_
+
+#include "FramI2C.h"
+
+
+class FramI2CAsync
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+    typedef void (*CompletionCallback)(const ResultCode resultcode, void* const context);
+
+    FramI2CAsync();
+    ~FramI2CAsync();
+
+    // fram must be initialized. queueLength is the maximum number of pending requests.
+    // maxChunkSize limits the number of data bytes transferred per poll() (0 = I2C buffer length).
+    ResultCode begin(FramI2C& fram, const uint8_t queueLength = 4, const size_t maxChunkSize = 0);
+
+    // Discards pending requests (their callbacks are not called) and frees the queue.
+    void end(void);
+
+    bool isInitialized(void) const;
+    bool isBusy(void) const;
+    uint8_t pendingCount(void) const;
+
+    // Queue a request (linear addressing, see FramI2C). The range is checked when the request is queued.
+    // Returns QueueFullError if queueLength requests are pending.
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data,
+        const CompletionCallback callback = nullptr, void* const context = nullptr);
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data,
+        const CompletionCallback callback = nullptr, void* const context = nullptr);
+    ResultCode fill(const uint32_t address, const size_t byteCount, const uint8_t value,
+        const CompletionCallback callback = nullptr, void* const context = nullptr);
+
+    // Performs one I2C chunk of the oldest pending request. Should be called regularly, e.g. from loop().
+    // Returns the result of the chunk (Success if no request is pending).
+    ResultCode poll(void);
+
+    // Calls poll() until all pending requests are completed.
+    ResultCode waitAll(void);
+
+private:
+
+    enum class Operation : uint8_t
+    {
+        Read,
+        Write,
+        Fill
+    };
+
+    struct Request
+    {
+        Operation operation;
+        uint32_t address;
+        size_t byteCount;
+        size_t bytesDone;
+        uint8_t* data;
+        uint8_t value;
+        CompletionCallback callback;
+        void* context;
+    };
+
+    FramI2C* fram_ = nullptr;
+    Request* queue_ = nullptr;      // Ring buffer of queueLength_ requests.
+    uint8_t queueLength_ = 0;
+    uint8_t head_ = 0;              // Oldest pending request.
+    uint8_t count_ = 0;
+    size_t maxChunkSize_ = 0;
+    bool initialized_ = false;
+
+    ResultCode enqueue(const Operation operation, const uint32_t address, const size_t byteCount, uint8_t* const data,
+        const uint8_t value, const CompletionCallback callback, void* const context);
+};
+
+#endif  //FRAMI2CASYNC_H_
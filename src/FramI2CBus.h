@@ -0,0 +1,91 @@
+/* FramI2CBus.h
+ *
+ * Description:  Abstract I2C bus transport used by FramI2C.
+ *               FramI2C does not access the Wire library directly but performs all I2C transfers
+ *               via a FramI2CBus implementation that is passed to FramI2C's begin() method.
+ *               This allows FramI2C to be used with a second (or third) TwoWire instance,
+ *               with other (vendor specific) I2C drivers and with a simulated FRAM on a host.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CBUS_H_
+#define FRAMI2CBUS_H_
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+
+class FramI2CBus
+{
+
+public:
+
+    // Values returned by endTransmission().
+    // These are identical to the values returned by the Arduino Wire library.
+    enum TwiResultCode
+    {
+        TwiSuccess = 0,
+        TwiBufferOverflow = 1,
+        TwiAddressNack = 2,
+        TwiDataNack = 3,
+        TwiLineBusy = 4
+    };
+
+    virtual ~FramI2CBus() {}
+
+    // Size of the driver's transmit and receive buffers, i.e. the maximum number of bytes
+    // (including FRAM address bytes) that can be transferred in a single I2C transaction.
+    // The default is the size used by the Arduino AVR Wire library.
+    virtual size_t bufferLength(void) const
+    {
+        return 32;
+    }
+
+    // The methods below have the same semantics as their TwoWire counterparts.
+    // Bytes written with write() are queued until endTransmission() is called.
+    // write() returns the number of bytes queued (which is less than requested if the buffer is full).
+    virtual void beginTransmission(const uint8_t i2cAddress) = 0;
+    virtual size_t write(const uint8_t value) = 0;
+    virtual uint8_t endTransmission(const bool sendStop) = 0;
+
+    // Reads byteCount bytes from the device into the receive buffer.
+    // Returns the number of bytes received.
+    virtual size_t requestFrom(const uint8_t i2cAddress, const size_t byteCount, const bool sendStop) = 0;
+    virtual int read(void) = 0;
+
+    // Bulk transfer methods.
+    // Implementations should override these if the underlying driver supports bulk copies.
+    virtual size_t write(const uint8_t* const data, const size_t byteCount)
+    {
+        size_t bytesQueued = 0;
+        while (bytesQueued < byteCount && write(data[bytesQueued]) == 1)
+        {
+            ++bytesQueued;
+        }
+        return bytesQueued;
+    }
+
+    virtual size_t readBytes(uint8_t* const data, const size_t byteCount)
+    {
+        size_t bytesRead = 0;
+        while (bytesRead < byteCount)
+        {
+            int value = read();
+            if (value < 0)
+            {
+                break;
+            }
+            data[bytesRead++] = static_cast<uint8_t>(value);
+        }
+        return bytesRead;
+    }
+};
+
+#endif  //FRAMI2CBUS_H_
@@ -0,0 +1,80 @@
+/* FramI2CCrc.h
+ *
+ * Description:  CRC engines for checking the integrity of FRAM contents.
+ *               Used by FramI2C::checksum(), which feeds data straight from the I2C buffer
+ *               into a FramI2CCrc, but can also be used on its own (e.g. to compute the
+ *               expected CRC of a RAM buffer).
+ *
+ *               Supported algorithms (parameters as in the CRC catalogue):
+ *                 Crc16Ccitt  CRC-16/CCITT-FALSE  poly 0x1021, init 0xFFFF, not reflected, xorout 0x0000
+ *                 Crc32       CRC-32 (IEEE 802.3) poly 0x04C11DB7, init 0xFFFFFFFF, reflected, xorout 0xFFFFFFFF
+ *                 Crc32C      CRC-32C (Castagnoli) poly 0x1EDC6F41, init 0xFFFFFFFF, reflected, xorout 0xFFFFFFFF
+ *
+ *               The CRCs are computed with 256 entry lookup tables (in PROGMEM on AVR).
+ *               On hosts with CRC instructions these are used instead: SSE4.2 for CRC-32C
+ *               (compile with -msse4.2), ARMv8 CRC extension for CRC-32 and CRC-32C (-march=armv8-a+crc).
+ *
+ *               Example usage:
+ *                 FramI2CCrc crc(FramCrcAlgorithm::Crc32);
+ *                 crc.update(header, sizeof(header));
+ *                 crc.update(payload, sizeof(payload));
+ *                 uint32_t value = crc.value();
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CCRC_H_
+#define FRAMI2CCRC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+enum class FramCrcAlgorithm : uint8_t
+{
+    Crc16Ccitt = 0,
+    Crc32 = 1,
+    Crc32C = 2
+};
+
+
+class FramI2CCrc
+{
+
+public:
+
+    explicit FramI2CCrc(const FramCrcAlgorithm algorithm = FramCrcAlgorithm::Crc32);
+
+    FramCrcAlgorithm algorithm(void) const;
+
+    // Starts a new CRC computation.
+    void reset(void);
+
+    // Adds byteCount bytes of data to the CRC. Data may be added in any number of pieces.
+    void update(const uint8_t* const data, const size_t byteCount);
+
+    // CRC of all data added since the last reset() (16-bit CRCs in the lower 16 bits).
+    uint32_t value(void) const;
+
+    // CRC of a single buffer.
+    static uint32_t compute(const FramCrcAlgorithm algorithm, const uint8_t* const data, const size_t byteCount);
+
+    // Name of the algorithm, e.g. for printing.
+    static const char* algorithmName(const FramCrcAlgorithm algorithm);
+
+    // True if algorithm is computed with CRC instructions on this platform.
+    static bool isHardwareAccelerated(const FramCrcAlgorithm algorithm);
+
+private:
+
+    FramCrcAlgorithm algorithm_;
+    uint32_t crc_;      // CRC register (before the final xor).
+
+    static uint32_t updateCrc16Ccitt(uint32_t crc, const uint8_t* data, size_t byteCount);
+    static uint32_t updateCrc32(uint32_t crc, const uint8_t* data, size_t byteCount);
+    static uint32_t updateCrc32C(uint32_t crc, const uint8_t* data, size_t byteCount);
+};
+
+#endif  //FRAMI2CCRC_H_
@@ -0,0 +1,229 @@
+/* FramI2CEndian.h
+ *
+ * Description:  Byte order (endianness) helpers for storing multi-byte values in FRAM.
+ *               Used by readArray() and writeArray() to store values in a fixed byte order,
+ *               so that FRAM contents can be exchanged between platforms with different byte orders.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CENDIAN_H_
+#define FRAMI2CENDIAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+enum class FramByteOrder : uint8_t
+{
+    Native = 0,         // Byte order of the platform, no conversion.
+    LittleEndian = 1,
+    BigEndian = 2
+};
+
+
+// FramByteOrderType<T>::value is true for the types whose byte order readArray() and writeArray()
+// can convert: integral and floating point types of 1, 2, 4 or 8 bytes (not structs or arrays).
+template<typename T> struct FramByteOrderType { static const bool value = false; };
+
+template<> struct FramByteOrderType<bool>               { static const bool value = true; };
+template<> struct FramByteOrderType<char>               { static const bool value = true; };
+template<> struct FramByteOrderType<signed char>        { static const bool value = true; };
+template<> struct FramByteOrderType<unsigned char>      { static const bool value = true; };
+template<> struct FramByteOrderType<short>              { static const bool value = true; };
+template<> struct FramByteOrderType<unsigned short>     { static const bool value = true; };
+template<> struct FramByteOrderType<int>                { static const bool value = true; };
+template<> struct FramByteOrderType<unsigned int>       { static const bool value = true; };
+template<> struct FramByteOrderType<long>               { static const bool value = true; };
+template<> struct FramByteOrderType<unsigned long>      { static const bool value = true; };
+template<> struct FramByteOrderType<long long>          { static const bool value = true; };
+template<> struct FramByteOrderType<unsigned long long> { static const bool value = true; };
+template<> struct FramByteOrderType<float>              { static const bool value = true; };
+template<> struct FramByteOrderType<double>             { static const bool value = true; };
+template<> struct FramByteOrderType<long double>        { static const bool value = true; };
+
+
+class FramI2CEndian
+{
+
+public:
+
+    // Size of the stack buffer used by writeSwapped().
+#if defined(__AVR__)
+    static const size_t SwapBufferSize = 32;
+#else
+    static const size_t SwapBufferSize = 128;
+#endif
+
+    static bool isLittleEndianHost(void)
+    {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+        return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+        const uint16_t value = 1;
+        return *reinterpret_cast<const uint8_t*>(&value) == 1;
+#endif
+    }
+
+
+    static bool needsSwap(const FramByteOrder byteOrder)
+    {
+        // Returns true if values in byteOrder must be byte swapped to/from the platform's byte order.
+        return (byteOrder == FramByteOrder::LittleEndian && !isLittleEndianHost())
+            || (byteOrder == FramByteOrder::BigEndian && isLittleEndianHost());
+    }
+
+
+    static void swap(uint8_t* const data, const size_t elementSize, const size_t elementCount)
+    {
+        // Reverses the byte order of elementCount consecutive elements of elementSize bytes in place.
+        // data does not need to be aligned. Large batches of 2, 4 and 8 byte elements are swapped
+        // 16 bytes at a time with SSSE3 or NEON, or 8 bytes at a time on other 64-bit hosts.
+
+        const size_t swappedCount = swapWide(data, elementSize, elementCount);
+        uint8_t* element = data + swappedCount * elementSize;
+        const size_t remainingCount = elementCount - swappedCount;
+        switch (elementSize)
+        {
+            case 2:
+                for (size_t i = 0; i < remainingCount; ++i, element += 2)
+                {
+                    uint16_t value;
+                    memcpy(&value, element, 2);
+                    value = __builtin_bswap16(value);
+                    memcpy(element, &value, 2);
+                }
+                break;
+            case 4:
+                for (size_t i = 0; i < remainingCount; ++i, element += 4)
+                {
+                    uint32_t value;
+                    memcpy(&value, element, 4);
+                    value = __builtin_bswap32(value);
+                    memcpy(element, &value, 4);
+                }
+                break;
+            case 8:
+                for (size_t i = 0; i < remainingCount; ++i, element += 8)
+                {
+                    uint64_t value;
+                    memcpy(&value, element, 8);
+                    value = __builtin_bswap64(value);
+                    memcpy(element, &value, 8);
+                }
+                break;
+            default:
+                for (size_t i = 0; i < remainingCount; ++i, element += elementSize)
+                {
+                    for (size_t low = 0, high = elementSize - 1; low < high; ++low, --high)
+                    {
+                        uint8_t byte = element[low];
+                        element[low] = element[high];
+                        element[high] = byte;
+                    }
+                }
+                break;
+        }
+    }
+
+
+    template<typename Memory> static typename Memory::ResultCode writeSwapped(const Memory& memory, const uint32_t address,
+        const size_t elementSize, const size_t elementCount, const uint8_t* const data, const size_t chunkSize)
+    {
+        // Writes elementCount elements from data with reversed byte order via memory.writeBytes().
+        // The elements are copied and swapped in a stack buffer and written in chunks of whole
+        // elements of at most chunkSize (and SwapBufferSize) bytes, data itself is not modified.
+        // elementSize must be at most SwapBufferSize. The range must already have been validated.
+
+        uint8_t buffer[SwapBufferSize];
+        size_t maxChunkSize = (chunkSize < SwapBufferSize) ? chunkSize : SwapBufferSize;
+        size_t chunkElementCount = (maxChunkSize >= elementSize) ? maxChunkSize / elementSize : 1;
+
+        typename Memory::ResultCode resultcode = Memory::ResultCode::Success;
+        size_t elementsRemaining = elementCount;
+        size_t offset = 0;
+        while (elementsRemaining > 0 && resultcode == Memory::ResultCode::Success)
+        {
+            size_t count = (elementsRemaining < chunkElementCount) ? elementsRemaining : chunkElementCount;
+            size_t byteCount = count * elementSize;
+            memcpy(buffer, data + offset, byteCount);
+            swap(buffer, elementSize, count);
+            resultcode = memory.writeBytes(address + offset, byteCount, buffer);
+            offset += byteCount;
+            elementsRemaining -= count;
+        }
+        return resultcode;
+    }
+
+
+private:
+
+    static size_t swapWide(uint8_t* const data, const size_t elementSize, const size_t elementCount)
+    {
+        // Swaps the largest multiple of the vector width (16 or 8 bytes) of elements that fits.
+        // Returns the number of elements swapped, the remaining elements are swapped by swap().
+
+        if (elementSize != 2 && elementSize != 4 && elementSize != 8)
+        {
+            return 0;
+        }
+#if defined(__SSSE3__)
+        const size_t byteCount = (elementSize * elementCount) & ~static_cast<size_t>(15);
+        const __m128i mask = (elementSize == 2) ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+                           : (elementSize == 4) ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+                           : _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+        for (size_t i = 0; i < byteCount; i += 16)
+        {
+            __m128i* vector = reinterpret_cast<__m128i*>(data + i);
+            _mm_storeu_si128(vector, _mm_shuffle_epi8(_mm_loadu_si128(vector), mask));
+        }
+        return byteCount / elementSize;
+#elif defined(__ARM_NEON)
+        const size_t byteCount = (elementSize * elementCount) & ~static_cast<size_t>(15);
+        for (size_t i = 0; i < byteCount; i += 16)
+        {
+            uint8x16_t vector = vld1q_u8(data + i);
+            vector = (elementSize == 2) ? vrev16q_u8(vector) : (elementSize == 4) ? vrev32q_u8(vector) : vrev64q_u8(vector);
+            vst1q_u8(data + i, vector);
+        }
+        return byteCount / elementSize;
+#elif defined(__SIZEOF_POINTER__) && __SIZEOF_POINTER__ >= 8
+        // Word at a time: the byte pairs (2) or halves (4) of a 64-bit word are exchanged in registers.
+        // The lane masks and rotations are symmetric, so this works on both little and big endian hosts.
+        const size_t byteCount = (elementSize * elementCount) & ~static_cast<size_t>(7);
+        for (size_t i = 0; i < byteCount; i += 8)
+        {
+            uint64_t value;
+            memcpy(&value, data + i, 8);
+            if (elementSize == 2)
+            {
+                value = ((value & 0x00FF00FF00FF00FFull) << 8) | ((value >> 8) & 0x00FF00FF00FF00FFull);
+            }
+            else
+            {
+                value = __builtin_bswap64(value);
+                if (elementSize == 4)
+                {
+                    value = (value << 32) | (value >> 32);
+                }
+            }
+            memcpy(data + i, &value, 8);
+        }
+        return byteCount / elementSize;
+#else
+        (void)data;
+        (void)elementCount;
+        return 0;
+#endif
+    }
+};
+
+#endif  //FRAMI2CENDIAN_H_
@@ -0,0 +1,244 @@
+/* FramI2CFixed.h
+ *
+ * Description:  FramI2CFixed is a FramI2C variant for a FRAM chip whose density (and I2C address)
+ *               is known at compile time. Memory size, page size, page count and the number of
+ *               address bytes are constexpr (FramI2CGeometry.h), unsupported densities are rejected
+ *               with static_assert. Range checks and the page split of linear addresses are runtime
+ *               code that uses these constants, so for constant arguments (e.g. read(0x10, value)) the
+ *               optimizer folds them and only the check whether begin() succeeded remains; single page
+ *               chips never split transfers. An out of range constant address is not a compile error,
+ *               it returns MemoryRangeError like FramI2C (only sizeof(T) is checked with static_assert).
+ *
+ *               FramI2CFixed performs its transfers with the FramI2C instance it contains, so
+ *               streaming read, write verify and the write observer apply as usual. fram() gives
+ *               access to the complete FramI2C API (e.g. for FramArray or hexdumpFram()).
+ *
+ *               Example usage (1 Mb FRAM on I2C addresses 0x50 and 0x51):
+ *                 FramI2CFixed<1024> fram;
+ *                 fram.begin();                   // or fram.begin(framBus)
+ *                 fram.write(0x10000, temperature);   // Check and page split folded by the optimizer: page 1, address 0.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CFIXED_H_
+#define FRAMI2CFIXED_H_
+
+#include "FramI2C.h"
+#include "FramI2CGeometry.h"
+
+
+template<uint16_t DensityInKiloBits, uint8_t BaseI2CAddress = 0x50>
+class FramI2CFixed
+{
+    static_assert(FramI2CGeometry::isDensitySupported(DensityInKiloBits), "Unsupported FRAM density");
+    static_assert(BaseI2CAddress + FramI2CGeometry::pageCount(DensityInKiloBits) <= 0x80,
+        "FRAM pages must be on 7-bit I2C addresses");
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    static constexpr uint16_t Density = DensityInKiloBits;
+    static constexpr uint8_t I2CAddress = BaseI2CAddress;
+    static constexpr uint32_t MemorySize = FramI2CGeometry::memorySize(DensityInKiloBits);
+    static constexpr uint32_t PageSize = FramI2CGeometry::pageSize(DensityInKiloBits);
+    static constexpr uint8_t PageCount = FramI2CGeometry::pageCount(DensityInKiloBits);
+    static constexpr uint8_t AddressBytesCount = FramI2CGeometry::addressBytesCount(DensityInKiloBits);
+
+#if defined(ARDUINO)
+    ResultCode begin(const size_t i2cBufferLength = 0)
+    {
+        return fram_.begin(Density, I2CAddress, FramI2C::DefaultTypeBufferSize, i2cBufferLength);
+    }
+#endif
+
+    ResultCode begin(FramI2CBus& bus, const size_t i2cBufferLength = 0)
+    {
+        return fram_.begin(bus, Density, I2CAddress, FramI2C::DefaultTypeBufferSize, i2cBufferLength);
+    }
+
+    void end(void)
+    {
+        fram_.end();
+    }
+
+    bool isInitialized(void) const
+    {
+        return fram_.isInitialized();
+    }
+
+    FramI2C& fram(void)
+    {
+        return fram_;
+    }
+
+    const FramI2C& fram(void) const
+    {
+        return fram_;
+    }
+
+
+    // Overloads without page parameter use linear addressing: address 0 to MemorySize - 1.
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data) const
+    {
+        ResultCode resultcode = checkRange(address, byteCount, data);
+        if (resultcode != FramI2C::ResultCode::Success || PageCount == 1)
+        {
+            return (resultcode != FramI2C::ResultCode::Success) ? resultcode
+                : fram_.readPage(I2CAddress, static_cast<uint16_t>(address), byteCount, data);
+        }
+        size_t offset = 0;
+        while (offset < byteCount && resultcode == FramI2C::ResultCode::Success)
+        {
+            const uint32_t spanAddress = address + offset;
+            const size_t spanSize = spanBytes(spanAddress, byteCount - offset);
+            resultcode = fram_.readPage(pageI2cAddress(spanAddress), pageAddress(spanAddress), spanSize, data + offset);
+            offset += spanSize;
+        }
+        return resultcode;
+    }
+
+
+    ResultCode readBytes(const uint8_t page, const uint16_t address, const size_t byteCount, uint8_t* const data) const
+    {
+        ResultCode resultcode = checkPageRange(page, address, byteCount, data);
+        return (resultcode != FramI2C::ResultCode::Success) ? resultcode
+            : fram_.readPage(I2CAddress + page, address, byteCount, data);
+    }
+
+
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data) const
+    {
+        ResultCode resultcode = checkRange(address, byteCount, data);
+        if (resultcode != FramI2C::ResultCode::Success || PageCount == 1)
+        {
+            return (resultcode != FramI2C::ResultCode::Success) ? resultcode
+                : fram_.writePage(I2CAddress, static_cast<uint16_t>(address), byteCount, data);
+        }
+        size_t offset = 0;
+        while (offset < byteCount && resultcode == FramI2C::ResultCode::Success)
+        {
+            const uint32_t spanAddress = address + offset;
+            const size_t spanSize = spanBytes(spanAddress, byteCount - offset);
+            resultcode = fram_.writePage(pageI2cAddress(spanAddress), pageAddress(spanAddress), spanSize, data + offset);
+            offset += spanSize;
+        }
+        return resultcode;
+    }
+
+
+    ResultCode writeBytes(const uint8_t page, const uint16_t address, const size_t byteCount, const uint8_t* const data) const
+    {
+        ResultCode resultcode = checkPageRange(page, address, byteCount, data);
+        return (resultcode != FramI2C::ResultCode::Success) ? resultcode
+            : fram_.writePage(I2CAddress + page, address, byteCount, data);
+    }
+
+
+    ResultCode fill(const uint32_t address, const size_t byteCount, const uint8_t value) const
+    {
+        ResultCode resultcode = checkRange(address, byteCount, &value);
+        size_t offset = 0;
+        while (offset < byteCount && resultcode == FramI2C::ResultCode::Success)
+        {
+            const uint32_t spanAddress = address + offset;
+            const size_t spanSize = spanBytes(spanAddress, byteCount - offset);
+            resultcode = fram_.fillPage(pageI2cAddress(spanAddress), pageAddress(spanAddress), spanSize, value);
+            offset += spanSize;
+        }
+        return resultcode;
+    }
+
+
+    ResultCode fill(const uint8_t page, const uint16_t address, const size_t byteCount, const uint8_t value) const
+    {
+        ResultCode resultcode = checkPageRange(page, address, byteCount, &value);
+        return (resultcode != FramI2C::ResultCode::Success) ? resultcode
+            : fram_.fillPage(I2CAddress + page, address, byteCount, value);
+    }
+
+
+    template<typename T> ResultCode read(const uint8_t page, const uint16_t address, T& t) const
+    {
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        static_assert(sizeof(T) <= PageSize, "T does not fit in a FRAM page");
+        return readBytes(page, address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
+    }
+
+
+    template<typename T> ResultCode read(const uint32_t address, T& t) const
+    {
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        static_assert(sizeof(T) <= MemorySize, "T does not fit in FRAM");
+        return readBytes(address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
+    }
+
+
+    template<typename T> ResultCode write(const uint8_t page, const uint16_t address, const T& t) const
+    {
+        static_assert(__is_trivially_copyable(T), "write() requires a trivially copyable type");
+        static_assert(sizeof(T) <= PageSize, "T does not fit in a FRAM page");
+        return writeBytes(page, address, sizeof(T), reinterpret_cast<const uint8_t*>(&t));
+    }
+
+
+    template<typename T> ResultCode write(const uint32_t address, const T& t) const
+    {
+        static_assert(__is_trivially_copyable(T), "write() requires a trivially copyable type");
+        static_assert(sizeof(T) <= MemorySize, "T does not fit in FRAM");
+        return writeBytes(address, sizeof(T), reinterpret_cast<const uint8_t*>(&t));
+    }
+
+
+private:
+
+    FramI2C fram_;
+
+    static constexpr uint8_t pageI2cAddress(const uint32_t address)
+    {
+        return static_cast<uint8_t>(I2CAddress + address / PageSize);
+    }
+
+    static constexpr uint16_t pageAddress(const uint32_t address)
+    {
+        return static_cast<uint16_t>(address % PageSize);
+    }
+
+    static constexpr size_t spanBytes(const uint32_t address, const size_t byteCount)
+    {
+        // Number of bytes (max byteCount) from address up to the end of its page.
+        return (byteCount < PageSize - pageAddress(address)) ? byteCount : PageSize - pageAddress(address);
+    }
+
+    ResultCode checkRange(const uint32_t address, const size_t byteCount, const void* const data) const
+    {
+        // Same checks and result codes as FramI2C's linear addressing methods.
+        return !fram_.initialized_ ? FramI2C::ResultCode::NotInitializedError
+             : (data == nullptr) ? FramI2C::ResultCode::NullPtrError
+             : (address >= MemorySize || byteCount > MemorySize - address) ? FramI2C::ResultCode::MemoryRangeError
+             : FramI2C::ResultCode::Success;
+    }
+
+    ResultCode checkPageRange(const uint8_t page, const uint16_t address, const size_t byteCount, const void* const data) const
+    {
+        // Same checks and result codes as FramI2C's methods with page parameter.
+        return !fram_.initialized_ ? FramI2C::ResultCode::NotInitializedError
+             : (data == nullptr) ? FramI2C::ResultCode::NullPtrError
+             : (page >= PageCount) ? FramI2C::ResultCode::InvalidPageError
+             : (address >= PageSize || byteCount > PageSize - address) ? FramI2C::ResultCode::PageSizeRangeError
+             : FramI2C::ResultCode::Success;
+    }
+};
+
+
+template<uint16_t D, uint8_t A> constexpr uint16_t FramI2CFixed<D, A>::Density;
+template<uint16_t D, uint8_t A> constexpr uint8_t FramI2CFixed<D, A>::I2CAddress;
+template<uint16_t D, uint8_t A> constexpr uint32_t FramI2CFixed<D, A>::MemorySize;
+template<uint16_t D, uint8_t A> constexpr uint32_t FramI2CFixed<D, A>::PageSize;
+template<uint16_t D, uint8_t A> constexpr uint8_t FramI2CFixed<D, A>::PageCount;
+template<uint16_t D, uint8_t A> constexpr uint8_t FramI2CFixed<D, A>::AddressBytesCount;
+
+#endif  //FRAMI2CFIXED_H_
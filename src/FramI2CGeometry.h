@@ -0,0 +1,96 @@
+/* FramI2CGeometry.h
+ *
+ * Description:  Memory geometry of the supported FRAM densities: memory size, page size,
+ *               number of pages (I2C addresses) and number of address bytes.
+ *               Used by FramI2C, by the host simulator and by the host image tools, so that
+ *               all of them map addresses to pages identically. Does not depend on Arduino.
+ *               All functions are constexpr and can be evaluated at compile time.
+ *
+ *               Density (kb)  Memory size  Page size  Pages  Address bytes
+ *                  4             512        0x100       2        1
+ *                 16            2048        0x100       8        1
+ *                 64            8192        0x2000      1        2
+ *                128           16384        0x4000      1        2
+ *                256           32768        0x8000      1        2
+ *                512           65536        0x10000     1        2
+ *               1024          131072        0x10000     2        2
+ *
+ *               Functions return 0 for unsupported densities.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CGEOMETRY_H_
+#define FRAMI2CGEOMETRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+class FramI2CGeometry
+{
+
+public:
+
+    static const uint8_t SupportedDensityCount = 7;
+
+
+    // Supported densities in kilobits in ascending order, 0 if index >= SupportedDensityCount.
+    static constexpr uint16_t supportedDensity(const uint8_t index)
+    {
+        return index == 0 ? 4 : index == 1 ? 16 : index == 2 ? 64 : index == 3 ? 128 :
+               index == 4 ? 256 : index == 5 ? 512 : index == 6 ? 1024 : 0;
+    }
+
+
+    static constexpr bool isDensitySupported(const uint16_t densityInKiloBits)
+    {
+        return densityInKiloBits == 4 || densityInKiloBits == 16 || densityInKiloBits == 64 ||
+               densityInKiloBits == 128 || densityInKiloBits == 256 || densityInKiloBits == 512 ||
+               densityInKiloBits == 1024;
+    }
+
+
+    // Memory size in bytes.
+    static constexpr uint32_t memorySize(const uint16_t densityInKiloBits)
+    {
+        return isDensitySupported(densityInKiloBits) ? static_cast<uint32_t>(densityInKiloBits) * 1024 / 8 : 0;
+    }
+
+
+    // Size of the memory addressed via a single I2C address.
+    static constexpr uint32_t pageSize(const uint16_t densityInKiloBits)
+    {
+        return !isDensitySupported(densityInKiloBits) ? 0
+             : densityInKiloBits <= 16 ? 0x100                         // Densities 4 and 16.
+             : densityInKiloBits <= 256 ? memorySize(densityInKiloBits) // Densities 64, 128 and 256.
+             : 0x10000;                                                 // Densities 512 and 1024.
+    }
+
+
+    // Number of pages, i.e. the number of consecutive I2C addresses the chip occupies.
+    static constexpr uint8_t pageCount(const uint16_t densityInKiloBits)
+    {
+        return isDensitySupported(densityInKiloBits)
+             ? static_cast<uint8_t>(memorySize(densityInKiloBits) / pageSize(densityInKiloBits)) : 0;
+    }
+
+
+    // Number of address bytes sent after the I2C address.
+    static constexpr uint8_t addressBytesCount(const uint16_t densityInKiloBits)
+    {
+        return !isDensitySupported(densityInKiloBits) ? 0 : pageSize(densityInKiloBits) == 0x100 ? 1 : 2;
+    }
+
+
+    // Density in kilobits of a memory of memorySize bytes, 0 if no supported density matches.
+    static constexpr uint16_t memorySizeToDensity(const uint32_t memorySize)
+    {
+        return (memorySize % 128 == 0 && memorySize / 128 <= 0xFFFF && isDensitySupported(static_cast<uint16_t>(memorySize / 128)))
+             ? static_cast<uint16_t>(memorySize / 128) : 0;
+    }
+};
+
+#endif  //FRAMI2CGEOMETRY_H_
@@ -0,0 +1,92 @@
+/* FramI2CPacked.h
+ *
+ * Description:  Definition of the portable packed FRAM data format used by FramI2CSerializer,
+ *               FramI2CDeserializer and the host tools.
+ *
+ *               Values are stored without padding, in little-endian byte order:
+ *                 bool                  1 byte (0 or 1)
+ *                 uint8_t, int8_t       1 byte
+ *                 uint16_t, int16_t     2 bytes
+ *                 uint32_t, int32_t     4 bytes
+ *                 uint64_t, int64_t     8 bytes
+ *                 float                 4 bytes, IEEE 754 binary32
+ *                 double                8 bytes, IEEE 754 binary64 (only on platforms where double
+ *                                       is 64 bits, not on AVR where double is the same as float)
+ *               Arrays are stored as consecutive values. Other types (structs, int, long, etc.)
+ *               are not supported because their size or layout differs between platforms and compilers,
+ *               they cause a compile error. Structs must be serialized field by field.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CPACKED_H_
+#define FRAMI2CPACKED_H_
+
+#include "FramI2CEndian.h"
+
+
+// FramPackedType<T>::size is the size of T in the packed format.
+// Not defined for unsupported types.
+template<typename T> struct FramPackedType;
+
+template<> struct FramPackedType<bool>     { static const size_t size = 1; };
+template<> struct FramPackedType<uint8_t>  { static const size_t size = 1; };
+template<> struct FramPackedType<int8_t>   { static const size_t size = 1; };
+template<> struct FramPackedType<uint16_t> { static const size_t size = 2; };
+template<> struct FramPackedType<int16_t>  { static const size_t size = 2; };
+template<> struct FramPackedType<uint32_t> { static const size_t size = 4; };
+template<> struct FramPackedType<int32_t>  { static const size_t size = 4; };
+template<> struct FramPackedType<uint64_t> { static const size_t size = 8; };
+template<> struct FramPackedType<int64_t>  { static const size_t size = 8; };
+template<> struct FramPackedType<float>    { static const size_t size = 4; };
+#if defined(__SIZEOF_DOUBLE__) && __SIZEOF_DOUBLE__ == 8
+template<> struct FramPackedType<double>   { static const size_t size = 8; };
+#endif
+
+
+class FramI2CPacked
+{
+
+public:
+
+    template<typename T> static void encode(const T* const values, const size_t count, uint8_t* const packed)
+    {
+        // Converts count values to the packed format in packed (count * FramPackedType<T>::size bytes).
+
+        static_assert(sizeof(T) == FramPackedType<T>::size, "Type size differs from packed size");
+        memcpy(packed, values, count * sizeof(T));
+        if (!FramI2CEndian::isLittleEndianHost())
+        {
+            FramI2CEndian::swap(packed, sizeof(T), count);
+        }
+    }
+
+
+    template<typename T> static void decode(const uint8_t* const packed, const size_t count, T* const values)
+    {
+        // Converts count values in the packed format to native values.
+
+        static_assert(sizeof(T) == FramPackedType<T>::size, "Type size differs from packed size");
+        memcpy(values, packed, count * sizeof(T));
+        if (!FramI2CEndian::isLittleEndianHost())
+        {
+            FramI2CEndian::swap(reinterpret_cast<uint8_t*>(values), sizeof(T), count);
+        }
+    }
+
+
+    template<typename T> static void decodeInPlace(T* const values, const size_t count)
+    {
+        // Converts count values that were read unmodified from the packed format in place.
+
+        static_assert(sizeof(T) == FramPackedType<T>::size, "Type size differs from packed size");
+        if (!FramI2CEndian::isLittleEndianHost())
+        {
+            FramI2CEndian::swap(reinterpret_cast<uint8_t*>(values), sizeof(T), count);
+        }
+    }
+};
+
+#endif  //FRAMI2CPACKED_H_
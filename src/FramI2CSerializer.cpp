@@ -0,0 +1,94 @@
+/* FramI2CSerializer.cpp
+ *
+ * Description:  Reads and writes values in the portable packed FRAM data format.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramI2CSerializer.h"
+
+
+// --- FramI2CSerializer ------------------------------------------------------
+
+FramI2CSerializer::FramI2CSerializer(const FramI2C& fram, const uint32_t address)
+    : fram_(fram), address_(address)
+{
+    // The buffer is written with a single I2C transaction (if it does not cross a page boundary).
+    size_t i2cChunkSize = fram.i2cBufferLength() - fram.addressBytesCount();
+    chunkSize_ = (i2cChunkSize < BufferSize) ? i2cChunkSize : BufferSize;
+}
+
+
+uint32_t FramI2CSerializer::address(void) const
+{
+    return address_ + used_;
+}
+
+
+FramI2CSerializer::ResultCode FramI2CSerializer::flush(void)
+{
+    if (used_ == 0)
+    {
+        return FramI2C::ResultCode::Success;
+    }
+    ResultCode resultcode = fram_.writeBytes(address_, used_, buffer_);
+    if (resultcode == FramI2C::ResultCode::Success)
+    {
+        address_ += used_;
+        used_ = 0;
+    }
+    return resultcode;
+}
+
+
+// --- FramI2CDeserializer ----------------------------------------------------
+
+FramI2CDeserializer::FramI2CDeserializer(const FramI2C& fram, const uint32_t address)
+    : fram_(fram), readAddress_(address)
+{
+    // A read transaction carries no FRAM address bytes, the complete I2C buffer is used for data.
+    chunkSize_ = (fram.i2cBufferLength() < BufferSize) ? fram.i2cBufferLength() : BufferSize;
+}
+
+
+uint32_t FramI2CDeserializer::address(void) const
+{
+    return readAddress_ - (end_ - position_);
+}
+
+
+FramI2CDeserializer::ResultCode FramI2CDeserializer::fill(const size_t minimumByteCount)
+{
+    // Moves the unread bytes to the start of the buffer and reads the next chunk behind them
+    // (max up to the end of FRAM memory). Fails if less than minimumByteCount bytes are available.
+
+    size_t unread = end_ - position_;
+    memmove(buffer_, buffer_ + position_, unread);
+    position_ = 0;
+    end_ = unread;
+
+    if (readAddress_ >= fram_.memorySize())
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    size_t byteCount = chunkSize_ - unread;
+    uint32_t bytesToMemoryEnd = fram_.memorySize() - readAddress_;
+    byteCount = (byteCount < bytesToMemoryEnd) ? byteCount : static_cast<size_t>(bytesToMemoryEnd);
+    if (unread + byteCount < minimumByteCount)
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    ResultCode resultcode = fram_.readBytes(readAddress_, byteCount, buffer_ + end_);
+    if (resultcode == FramI2C::ResultCode::Success)
+    {
+        end_ += byteCount;
+        readAddress_ += byteCount;
+    }
+    return resultcode;
+}
+
+
+/* eof */
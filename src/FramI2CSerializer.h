@@ -0,0 +1,207 @@
+/* FramI2CSerializer.h
+ *
+ * Description:  FramI2CSerializer writes and FramI2CDeserializer reads values in the portable packed
+ *               format (see FramI2CPacked.h): fixed size, little-endian, without padding.
+ *               Unlike write() and read(), which store the native memory layout, FRAM contents
+ *               written with FramI2CSerializer can be read on any platform (e.g. written on ESP32,
+ *               read on AVR or analyzed on a PC with FramImageDecoder).
+ *
+ *               Values are collected in a small buffer and written (read) in I2C chunks,
+ *               not one transaction per value. Large arrays are transferred directly.
+ *
+ *               Example usage:
+ *                 FramI2CSerializer serializer(fram, 0x100);
+ *                 serializer.write(static_cast<uint16_t>(1));     // Format version.
+ *                 serializer.write(temperature);                  // float
+ *                 serializer.writeArray(samples, 64);             // int16_t[64]
+ *                 serializer.flush();
+ *
+ *                 FramI2CDeserializer deserializer(fram, 0x100);
+ *                 deserializer.read(version);
+ *                 deserializer.read(temperature);
+ *                 deserializer.readArray(samples, 64);
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CSERIALIZER_H_
+#define FRAMI2CSERIALIZER_H_
+
+#include "FramI2C.h"
+#include "FramI2CPacked.h"
+
+
+class FramI2CSerializer
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+#if defined(__AVR__)
+    static const size_t BufferSize = 32;
+#else
+    static const size_t BufferSize = 128;
+#endif
+
+    // fram must be initialized. Values are written consecutively starting at linear address.
+    FramI2CSerializer(const FramI2C& fram, const uint32_t address);
+
+    // Address where the next value is stored.
+    uint32_t address(void) const;
+
+    // Writes the buffered values to FRAM. Must be called after the last value,
+    // buffered values are not written when the serializer is destroyed.
+    ResultCode flush(void);
+
+
+    template<typename T> ResultCode write(const T value)
+    {
+        return writeArray(&value, 1);
+    }
+
+
+    template<typename T> ResultCode writeArray(const T* const values, const size_t count)
+    {
+        // Writes count values. Values are buffered, the buffer is written when it is full.
+
+        const size_t size = FramPackedType<T>::size;
+        if (values == nullptr)
+        {
+            return FramI2C::ResultCode::NullPtrError;
+        }
+        if (count > fram_.memorySize() / size)
+        {
+            return FramI2C::ResultCode::MemoryRangeError;
+        }
+
+        ResultCode resultcode = FramI2C::ResultCode::Success;
+        if (count * size >= chunkSize_ && FramI2CEndian::isLittleEndianHost())
+        {
+            // Native layout is the packed layout: write directly from values.
+            resultcode = flush();
+            if (resultcode == FramI2C::ResultCode::Success)
+            {
+                resultcode = fram_.writeBytes(address_, count * size, reinterpret_cast<const uint8_t*>(values));
+                address_ += (resultcode == FramI2C::ResultCode::Success) ? count * size : 0;
+            }
+            return resultcode;
+        }
+
+        size_t remaining = count;
+        const T* value = values;
+        while (remaining > 0 && resultcode == FramI2C::ResultCode::Success)
+        {
+            size_t fitting = (chunkSize_ - used_) / size;
+            if (fitting == 0)
+            {
+                resultcode = flush();
+                continue;
+            }
+            size_t batch = (remaining < fitting) ? remaining : fitting;
+            FramI2CPacked::encode(value, batch, buffer_ + used_);
+            used_ += batch * size;
+            value += batch;
+            remaining -= batch;
+        }
+        return resultcode;
+    }
+
+
+private:
+
+    const FramI2C& fram_;
+    uint32_t address_;              // FRAM address of buffer_[0].
+    size_t chunkSize_;              // Usable part of buffer_: one I2C chunk (max BufferSize).
+    size_t used_ = 0;
+    uint8_t buffer_[BufferSize];
+};
+
+
+class FramI2CDeserializer
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    static const size_t BufferSize = FramI2CSerializer::BufferSize;
+
+    // fram must be initialized. Values are read consecutively starting at linear address.
+    // Data is read ahead in I2C chunks, changes made to FRAM after a chunk was read are not seen.
+    FramI2CDeserializer(const FramI2C& fram, const uint32_t address);
+
+    // Address of the next value.
+    uint32_t address(void) const;
+
+
+    template<typename T> ResultCode read(T& value)
+    {
+        return readArray(&value, 1);
+    }
+
+
+    template<typename T> ResultCode readArray(T* const values, const size_t count)
+    {
+        // Reads count values. If the read fails values may be partially modified.
+
+        const size_t size = FramPackedType<T>::size;
+        if (values == nullptr)
+        {
+            return FramI2C::ResultCode::NullPtrError;
+        }
+        if (count > fram_.memorySize() / size)
+        {
+            return FramI2C::ResultCode::MemoryRangeError;
+        }
+
+        ResultCode resultcode = FramI2C::ResultCode::Success;
+        size_t remaining = count;
+        T* value = values;
+        while (remaining > 0 && resultcode == FramI2C::ResultCode::Success)
+        {
+            size_t buffered = (end_ - position_) / size;
+            if (buffered == 0)
+            {
+                if (end_ == position_ && remaining * size >= chunkSize_)
+                {
+                    // Nothing buffered and a large array: read directly into values.
+                    resultcode = fram_.readBytes(readAddress_, remaining * size, reinterpret_cast<uint8_t*>(value));
+                    if (resultcode == FramI2C::ResultCode::Success)
+                    {
+                        FramI2CPacked::decodeInPlace(value, remaining);
+                        readAddress_ += remaining * size;
+                        remaining = 0;
+                    }
+                }
+                else
+                {
+                    resultcode = fill(size);
+                }
+                continue;
+            }
+            size_t batch = (remaining < buffered) ? remaining : buffered;
+            FramI2CPacked::decode(buffer_ + position_, batch, value);
+            position_ += batch * size;
+            value += batch;
+            remaining -= batch;
+        }
+        return resultcode;
+    }
+
+
+private:
+
+    const FramI2C& fram_;
+    uint32_t readAddress_;          // FRAM address of buffer_[end_].
+    size_t chunkSize_;
+    size_t position_ = 0;           // Next unread byte in buffer_.
+    size_t end_ = 0;                // End of valid data in buffer_.
+    uint8_t buffer_[BufferSize];
+
+    ResultCode fill(const size_t minimumByteCount);
+};
+
+#endif  //FRAMI2CSERIALIZER_H_
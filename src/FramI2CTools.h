@@ -12,6 +12,7 @@
 
 #include <Arduino.h>
 #include "FramI2C.h"
+#include "FramI2CTransfer.h"
 
 
 void printChars(Stream& stream, char ch, uint8_t count, bool linefeed = false)
@@ -33,6 +34,10 @@ void printSpaces(Stream& stream, uint8_t count, bool linefeed = false)
 }
 
 
+static const char FramHexDigitsUpper[] = "0123456789ABCDEF";
+static const char FramHexDigitsLower[] = "0123456789abcdef";
+
+
 void printHex(Stream& stream, uint32_t value, bool prefix = true, uint8_t width = 0, bool uppercase = true)
 {
     // Prints hex value to stream.
@@ -40,16 +45,24 @@ void printHex(Stream& stream, uint32_t value, bool prefix = true, uint8_t width
     // If string length is uneven then a leading zero is added (0xF => "0x0F").
     // If width > value string length then multiple leading zeros will be added.
     // Note that width does not include the "0x" prefix.
+    // Digits are formatted with a lookup table into a small buffer (no String on the heap).
 
-    uint8_t zeros;
-    String s(value, HEX);
-    uint8_t len = s.length();
-
-    if (uppercase)
+    const char* const hexDigits = uppercase ? FramHexDigitsUpper : FramHexDigitsLower;
+    char s[9];
+    uint8_t len = 0;
+    char digits[8];
+    do
+    {
+        digits[len++] = hexDigits[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+    for (uint8_t i = 0; i < len; ++i)
     {
-        s.toUpperCase();
+        s[i] = digits[len - 1 - i];
     }
+    s[len] = '\0';
 
+    uint8_t zeros;
     if (width == 0)
     {
         zeros = len % 2;
@@ -132,9 +145,9 @@ void printFramInfo(Stream& stream, FramI2C& fram, const char* const instanceName
         printSpaces(stream, 7);        
         stream.println(fram.pageCount(), DEC);
 
-        // stream.printf("Type buffer size: %u B\n\n", fram.typebufferSize());
-        stream.print(F("Type buffer size: "));
-        stream.print(fram.typebufferSize());
+        // stream.printf("I2C buffer length: %u B\n\n", fram.i2cBufferLength());
+        stream.print(F("I2C buffer length: "));
+        stream.print(fram.i2cBufferLength());
         stream.println(F(" B"));           
     }
 
@@ -220,11 +233,32 @@ void printResultCodeDescription(
             stream.print(F("Out of page size range."));
             break;
         case FramI2C::ResultCode::BufferAllocationFailedError:		
-            stream.print(F("Type buffer allocation failed."));
+            stream.print(F("Buffer allocation failed."));
             break;
         case FramI2C::ResultCode::BufferOverflowError:		
             stream.print(F("Type too large for buffer."));
             break;
+        case FramI2C::ResultCode::I2CBufferLengthError:		
+            stream.print(F("Invalid I2C buffer length."));
+            break;
+        case FramI2C::ResultCode::MemoryRangeError:		
+            stream.print(F("Out of memory size range."));
+            break;
+        case FramI2C::ResultCode::InvalidChipCountError:		
+            stream.print(F("Invalid chip count."));
+            break;
+        case FramI2C::ResultCode::QueueFullError:		
+            stream.print(F("Request queue full."));
+            break;
+        case FramI2C::ResultCode::VerifyError:		
+            stream.print(F("Verify failed, data differs."));
+            break;
+        case FramI2C::ResultCode::TransferError:		
+            stream.print(F("Stream transfer failed."));
+            break;
+        case FramI2C::ResultCode::DensityDetectionError:		
+            stream.print(F("Density could not be detected."));
+            break;
         case FramI2C::ResultCode::Uninitialized:		
             stream.print(F("Uninitialized."));
             break;
@@ -248,8 +282,15 @@ FramI2C::ResultCode hexdumpFram(
     const uint32_t byteCount, 
     const bool header = true, 
     const char* const message = "", 
-    const uint8_t linefeeds = 1)
+    const uint8_t linefeeds = 1,
+    const bool ascii = false)
 {
+    // Prints a hexdump of byteCount bytes of page, starting at address, 16 bytes per row.
+    // If ascii is true, every row is followed by its bytes as characters ('.' for non printable characters).
+    // Data is read in blocks of several rows. Each row is formatted with a lookup table into a line
+    // buffer and written to stream with a single write.
+
+    (void)message;
     // char pageString[9] = "";
     String pageStr;
 
@@ -288,7 +329,7 @@ FramI2C::ResultCode hexdumpFram(
         return FramI2C::ResultCode::InvalidPageError;
     }    	
 
-    if ((address >= fram.pageSize()) || (byteCount + address) > fram.pageSize())
+    if ((address >= fram.pageSize()) || byteCount > (fram.pageSize() - address))
     {
         printResultCodeDescription(stream, FramI2C::ResultCode::PageSizeRangeError, linefeeds);
         return FramI2C::ResultCode::PageSizeRangeError;
@@ -321,66 +362,98 @@ FramI2C::ResultCode hexdumpFram(
         stream.println();
     }
 
-    // Output data
-
-    uint16_t lineNr = 0;
-    uint16_t firstByteColumnOffset = address & 0xF;
-    if (firstByteColumnOffset > 0)
+    // Output data.
+    // Row layout: "AAAA:" + 16 * " HH" with " -" before column 8 [+ "  |" + 16 characters + "|"] + "\r\n".
+    // Columns before address (first row) and after the last byte (last row) are filled with spaces.
+
+#if defined(__AVR__)
+    const uint8_t blockRowCount = 4;
+#else
+    const uint8_t blockRowCount = 16;
+#endif
+    uint8_t block[blockRowCount * 16];
+    char line[5 + 16 * 3 + 2 + 3 + 16 + 1 + 2];
+    FramI2C::ResultCode resultcode = FramI2C::ResultCode::Success;
+    uint32_t rowAddress = address & 0xFFF0;
+    const uint32_t endAddress = static_cast<uint32_t>(address) + byteCount;
+
+    while (rowAddress < endAddress)
     {
-        ++lineNr;
-        // Output first adreslabel and indent
-        printHex(stream, address & 0xFFF0, false, 4); 
-        stream.print(":");
-        for (uint8_t i = 0; i < firstByteColumnOffset; ++i)		
+        // Read the bytes of up to blockRowCount rows.
+        uint32_t blockStart = (rowAddress < address) ? address : rowAddress;
+        uint32_t blockEnd = rowAddress + sizeof(block);
+        blockEnd = (blockEnd < endAddress) ? blockEnd : endAddress;
+        resultcode = fram.readBytes(page, static_cast<uint16_t>(blockStart), blockEnd - blockStart, block);
+        if (resultcode != FramI2C::ResultCode::Success)
         {
-            if (i == 8 && (firstByteColumnOffset) >= 8)
-            {
-                printSpaces(stream, 2);
-            } 
-            printSpaces(stream, 3);
+            printResultCodeDescription(stream, resultcode, 1);
+            break;
         }
-    }
 
-    // Output byte values
-    FramI2C::ResultCode resultcode = FramI2C::ResultCode::Uninitialized;
-    uint16_t addr = address;	
-    for (uint32_t i = 0; i < byteCount; ++i)
-    {
-        // stream.printf("[index=%u, addr=0x%04X, lineNr=%u]", index, addr, lineNr); //debug
-        if ((addr & 0xF) == 0)
+        for (; rowAddress < blockEnd; rowAddress += 16)
         {
-#if defined(ESP8266)
-            // If ESP8266 MCU yield() once every 16 bytes to prevent WDT resets.
-            yield();
-#endif						
-            ++lineNr;
-            if (lineNr > 1)
+            size_t length = 0;
+            for (int8_t shift = 12; shift >= 0; shift -= 4)
             {
-                stream.println();
+                line[length++] = FramHexDigitsUpper[(rowAddress >> shift) & 0xF];
             }
-            // Write address label
-            printHex(stream, addr & 0xFFF0, false, 4);             
-            stream.print(":");
-        }
-        if ((addr & 0xF) ==  8)
-        {
-            stream.print(" -");
-        }		
-        uint8_t value = 0;
-        resultcode = fram.readBytes(page, addr, 1, &value);
-        if (resultcode != FramI2C::ResultCode::Success)
-        {
-            stream.println();
-            printResultCodeDescription(stream, resultcode, 0);
-            break;
+            line[length++] = ':';
+            for (uint8_t column = 0; column < 16; ++column)
+            {
+                uint32_t byteAddress = rowAddress + column;
+                bool present = byteAddress >= blockStart && byteAddress < blockEnd;
+                if (!present && byteAddress >= blockEnd && !ascii)
+                {
+                    // Padding after the last byte is only needed to align the ASCII column.
+                    break;
+                }
+                if (column == 8)
+                {
+                    line[length++] = ' ';
+                    line[length++] = present ? '-' : ' ';
+                }
+                if (present)
+                {
+                    uint8_t value = block[byteAddress - blockStart];
+                    line[length++] = ' ';
+                    line[length++] = FramHexDigitsUpper[value >> 4];
+                    line[length++] = FramHexDigitsUpper[value & 0xF];
+                }
+                else
+                {
+                    line[length++] = ' ';
+                    line[length++] = ' ';
+                    line[length++] = ' ';
+                }
+            }
+            if (ascii)
+            {
+                line[length++] = ' ';
+                line[length++] = ' ';
+                line[length++] = '|';
+                for (uint8_t column = 0; column < 16; ++column)
+                {
+                    uint32_t byteAddress = rowAddress + column;
+                    if (byteAddress >= blockStart && byteAddress < blockEnd)
+                    {
+                        uint8_t value = block[byteAddress - blockStart];
+                        line[length++] = (value >= 0x20 && value < 0x7F) ? static_cast<char>(value) : '.';
+                    }
+                    else
+                    {
+                        line[length++] = ' ';
+                    }
+                }
+                line[length++] = '|';
+            }
+            line[length++] = '\r';
+            line[length++] = '\n';
+            stream.write(reinterpret_cast<const uint8_t*>(line), length);
         }
-        stream.print(" ");        
-        printHex(stream, value, false, 2);             
-        ++addr;
-    }
-    if (resultcode == FramI2C::ResultCode::Success)
-    {
-        stream.println();
+#if defined(ESP8266)
+        // If ESP8266 MCU yield() once every block to prevent WDT resets.
+        yield();
+#endif						
     }
     for (uint8_t i = 0; i < linefeeds; ++i)
     {
@@ -398,11 +471,286 @@ FramI2C::ResultCode hexdumpFram(
     const uint32_t byteCount, 
     const bool header = true, 
     const char* const message = nullptr, 
-    const uint8_t linefeeds = 1)
+    const uint8_t linefeeds = 1,
+    const bool ascii = false)
                                         
 {
     // Overload without page parameter.
-    return hexdumpFram(stream, fram, 0, address, byteCount, header, message, linefeeds);
+    return hexdumpFram(stream, fram, 0, address, byteCount, header, message, linefeeds, ascii);
+}
+
+
+FramI2C::ResultCode dumpBinary(Stream& stream, FramI2C& fram, const uint32_t address, const uint32_t byteCount)
+{
+    // Sends byteCount bytes starting at linear address as framed, CRC protected binary blocks
+    // (see FramI2CTransfer.h), e.g. to extras/host/FramImageTransfer on a PC.
+    // FRAM reads are pipelined with transmission: while a block is being sent, the next block is read
+    // one I2C chunk at a time and in between as many bytes of the current block are written as fit
+    // in the stream's transmit buffer (availableForWrite()).
+
+    if (!fram.isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((address >= fram.memorySize()) || byteCount > (fram.memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    const size_t blockSize = FramI2CTransfer::BlockSize;
+    const size_t frameCapacity = FramI2CTransfer::FrameHeaderSize + FramI2CTransfer::BlockSize + FramI2CTransfer::FrameCrcSize;
+    uint8_t frames[2][frameCapacity];
+
+    // Magic and header frame.
+    uint8_t header[FramI2CTransfer::MagicSize + FramI2CTransfer::FrameHeaderSize + FramI2CTransfer::HeaderPayloadSize + FramI2CTransfer::FrameCrcSize];
+    uint8_t* headerFrame = header + FramI2CTransfer::MagicSize;
+    uint8_t* headerPayload = headerFrame + FramI2CTransfer::FrameHeaderSize;
+    FramI2CTransfer::encode32(header, FramI2CTransfer::Magic);
+    FramI2CTransfer::encodeFrameHeader(headerFrame, FramI2CTransfer::HeaderFrame, address, FramI2CTransfer::HeaderPayloadSize);
+    FramI2CTransfer::encode32(headerPayload, byteCount);
+    FramI2CTransfer::encode16(headerPayload + 4, blockSize);
+    FramI2CTransfer::encode32(headerPayload + FramI2CTransfer::HeaderPayloadSize,
+        FramI2CTransfer::frameCrc(headerFrame, headerPayload, FramI2CTransfer::HeaderPayloadSize));
+    stream.write(header, sizeof(header));
+
+    // Data frames.
+    FramI2CCrc rangeCrc(FramCrcAlgorithm::Crc32);
+    const size_t chunkSize = fram.i2cBufferLength();
+    const uint32_t endAddress = address + byteCount;
+    uint8_t current = 0;
+    uint32_t frameAddress = address;
+    size_t currentLength = (byteCount < blockSize) ? byteCount : blockSize;
+    FramI2C::ResultCode resultcode = fram.readBytes(frameAddress, currentLength, frames[current] + FramI2CTransfer::FrameHeaderSize);
+    if (resultcode != FramI2C::ResultCode::Success)
+    {
+        return resultcode;
+    }
+
+    while (currentLength > 0)
+    {
+        // Complete the frame of the current block.
+        uint8_t* frame = frames[current];
+        uint8_t* data = frame + FramI2CTransfer::FrameHeaderSize;
+        FramI2CTransfer::encodeFrameHeader(frame, FramI2CTransfer::DataFrame, frameAddress, currentLength);
+        FramI2CTransfer::encode32(data + currentLength, FramI2CTransfer::frameCrc(frame, data, currentLength));
+        rangeCrc.update(data, currentLength);
+        const size_t frameLength = FramI2CTransfer::FrameHeaderSize + currentLength + FramI2CTransfer::FrameCrcSize;
+        size_t bytesSent = 0;
+
+        // Read the next block while the current frame is being sent.
+        const uint8_t next = current ^ 1;
+        const uint32_t nextAddress = frameAddress + currentLength;
+        size_t nextLength = endAddress - nextAddress;
+        nextLength = (nextLength < blockSize) ? nextLength : blockSize;
+        size_t bytesRead = 0;
+        while (bytesRead < nextLength)
+        {
+            size_t readSize = nextLength - bytesRead;
+            readSize = (readSize < chunkSize) ? readSize : chunkSize;
+            resultcode = fram.readBytes(nextAddress + bytesRead, readSize, frames[next] + FramI2CTransfer::FrameHeaderSize + bytesRead);
+            if (resultcode != FramI2C::ResultCode::Success)
+            {
+                return resultcode;
+            }
+            bytesRead += readSize;
+
+            int available = stream.availableForWrite();
+            if (available > 0 && bytesSent < frameLength)
+            {
+                size_t writeSize = frameLength - bytesSent;
+                writeSize = (writeSize < static_cast<size_t>(available)) ? writeSize : available;
+                bytesSent += stream.write(frame + bytesSent, writeSize);
+            }
+        }
+
+        // Send the rest of the current frame (waits until it fits in the transmit buffer).
+        stream.write(frame + bytesSent, frameLength - bytesSent);
+        current = next;
+        frameAddress = nextAddress;
+        currentLength = nextLength;
+    }
+
+    // End frame with the CRC of the complete range.
+    uint8_t end[FramI2CTransfer::FrameHeaderSize + FramI2CTransfer::EndPayloadSize + FramI2CTransfer::FrameCrcSize];
+    uint8_t* endPayload = end + FramI2CTransfer::FrameHeaderSize;
+    FramI2CTransfer::encodeFrameHeader(end, FramI2CTransfer::EndFrame, address, FramI2CTransfer::EndPayloadSize);
+    FramI2CTransfer::encode32(endPayload, rangeCrc.value());
+    FramI2CTransfer::encode32(endPayload + FramI2CTransfer::EndPayloadSize,
+        FramI2CTransfer::frameCrc(end, endPayload, FramI2CTransfer::EndPayloadSize));
+    stream.write(end, sizeof(end));
+    stream.flush();
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+FramI2C::ResultCode dumpBinary(Stream& stream, FramI2C& fram)
+{
+    // Overload that sends the complete memory.
+    return dumpBinary(stream, fram, 0, fram.memorySize());
+}
+
+
+FramI2C::ResultCode receiveTransferFrame(Stream& stream, uint8_t* const frame, const size_t maxPayloadSize, uint16_t& length)
+{
+    // Receives a single frame into frame (FrameHeaderSize + maxPayloadSize + FrameCrcSize bytes) for restoreBinary().
+    // Returns TransferError if nothing is received (timeout), VerifyError if the frame is corrupted: wrong CRC,
+    // incomplete, or a payload larger than maxPayloadSize (corrupted length field).
+
+    size_t bytesReceived = stream.readBytes(frame, FramI2CTransfer::FrameHeaderSize);
+    if (bytesReceived == 0)
+    {
+        return FramI2C::ResultCode::TransferError;
+    }
+    if (bytesReceived != FramI2CTransfer::FrameHeaderSize)
+    {
+        return FramI2C::ResultCode::VerifyError;
+    }
+    length = FramI2CTransfer::decode16(frame + 5);
+    if (length > maxPayloadSize)
+    {
+        return FramI2C::ResultCode::VerifyError;
+    }
+    uint8_t* payload = frame + FramI2CTransfer::FrameHeaderSize;
+    if (stream.readBytes(payload, length + FramI2CTransfer::FrameCrcSize) != length + FramI2CTransfer::FrameCrcSize)
+    {
+        return FramI2C::ResultCode::VerifyError;
+    }
+    if (FramI2CTransfer::decode32(payload + length) != FramI2CTransfer::frameCrc(frame, payload, length))
+    {
+        return FramI2C::ResultCode::VerifyError;
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+void drainTransferInput(Stream& stream)
+{
+    // Discards received bytes until nothing has been received for IdleMillis. After a corrupted frame
+    // the rest of the frame (its length may be wrong) is still arriving; once the line is idle the host
+    // is waiting for the reply and the next frame starts at a frame boundary.
+    unsigned long lastReceived = millis();
+    while (millis() - lastReceived < FramI2CTransfer::IdleMillis)
+    {
+        if (stream.available() > 0)
+        {
+            stream.read();
+            lastReceived = millis();
+        }
+    }
+}
+
+
+FramI2C::ResultCode cancelTransfer(Stream& stream, const FramI2C::ResultCode resultcode)
+{
+    // Sends Cancel and the reason to the host, returns resultcode.
+    uint8_t reply[2] = {FramI2CTransfer::Cancel, static_cast<uint8_t>(resultcode)};
+    stream.write(reply, sizeof(reply));
+    stream.flush();
+    return resultcode;
+}
+
+
+FramI2C::ResultCode restoreBinary(Stream& stream, FramI2C& fram)
+{
+    // Receives an image sent with extras/host/FramImageTransfer (see FramI2CTransfer.h) and writes it to FRAM.
+    // Bytes received before the magic bytes are skipped. Every receive waits at most the stream's timeout
+    // (setTimeout()), if nothing is received TransferError is returned.
+    // Each block is written to FRAM before it is acknowledged, the host sends the next block after the
+    // acknowledge, so the stream's receive buffer cannot overflow while FRAM is being written.
+
+    if (!fram.isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+
+    // Wait for the magic bytes.
+    uint32_t magic = 0;
+    while (magic != FramI2CTransfer::Magic)
+    {
+        uint8_t value;
+        if (stream.readBytes(&value, 1) != 1)
+        {
+            return FramI2C::ResultCode::TransferError;
+        }
+        magic = (magic >> 8) | (static_cast<uint32_t>(value) << 24);
+    }
+
+    uint8_t frame[FramI2CTransfer::FrameHeaderSize + FramI2CTransfer::BlockSize + FramI2CTransfer::FrameCrcSize];
+    uint8_t* payload = frame + FramI2CTransfer::FrameHeaderSize;
+    uint16_t length = 0;
+    FramI2C::ResultCode resultcode = receiveTransferFrame(stream, frame, FramI2CTransfer::HeaderPayloadSize, length);
+    if (resultcode != FramI2C::ResultCode::Success || frame[0] != FramI2CTransfer::HeaderFrame || length != FramI2CTransfer::HeaderPayloadSize)
+    {
+        return cancelTransfer(stream, FramI2C::ResultCode::TransferError);
+    }
+    const uint32_t address = FramI2CTransfer::decode32(frame + 1);
+    const uint32_t byteCount = FramI2CTransfer::decode32(payload);
+    if ((address >= fram.memorySize()) || byteCount > (fram.memorySize() - address))
+    {
+        return cancelTransfer(stream, FramI2C::ResultCode::MemoryRangeError);
+    }
+    uint8_t reply[3] = {FramI2CTransfer::Ack, 0, 0};
+    FramI2CTransfer::encode16(reply + 1, FramI2CTransfer::BlockSize);
+    stream.write(reply, sizeof(reply));
+    stream.flush();
+
+    uint32_t nextAddress = address;
+    const uint32_t endAddress = address + byteCount;
+    while (true)
+    {
+        resultcode = receiveTransferFrame(stream, frame, FramI2CTransfer::BlockSize, length);
+        if (resultcode == FramI2C::ResultCode::VerifyError)
+        {
+            // Corrupted frame, the host sends it again after the Nak.
+            drainTransferInput(stream);
+            stream.write(FramI2CTransfer::Nak);
+            stream.flush();
+            continue;
+        }
+        if (resultcode != FramI2C::ResultCode::Success)
+        {
+            return cancelTransfer(stream, resultcode);
+        }
+
+        const uint32_t frameAddress = FramI2CTransfer::decode32(frame + 1);
+        if (frame[0] == FramI2CTransfer::DataFrame)
+        {
+            if (frameAddress != nextAddress || length == 0 || length > endAddress - nextAddress)
+            {
+                return cancelTransfer(stream, FramI2C::ResultCode::TransferError);
+            }
+            resultcode = fram.writeBytes(frameAddress, length, payload);
+            if (resultcode != FramI2C::ResultCode::Success)
+            {
+                return cancelTransfer(stream, resultcode);
+            }
+            nextAddress += length;
+        }
+        else if (frame[0] == FramI2CTransfer::EndFrame && length == FramI2CTransfer::EndPayloadSize && nextAddress == endAddress)
+        {
+            // Read back the CRC of the written range.
+            uint32_t crc = 0;
+            resultcode = fram.checksum(address, byteCount, FramCrcAlgorithm::Crc32, crc);
+            if (resultcode == FramI2C::ResultCode::Success && crc != FramI2CTransfer::decode32(payload))
+            {
+                resultcode = FramI2C::ResultCode::VerifyError;
+            }
+            if (resultcode != FramI2C::ResultCode::Success)
+            {
+                return cancelTransfer(stream, resultcode);
+            }
+            stream.write(FramI2CTransfer::Ack);
+            stream.flush();
+            return FramI2C::ResultCode::Success;
+        }
+        else
+        {
+            return cancelTransfer(stream, FramI2C::ResultCode::TransferError);
+        }
+        stream.write(FramI2CTransfer::Ack);
+        stream.flush();
+    }
 }
 
 #endif  //FRAMI2CTOOLS_H_
\ No newline at end of file
@@ -0,0 +1,124 @@
+/* FramI2CTransfer.h
+ *
+ * Description:  Frame format for binary transfer of FRAM images over a serial stream.
+ *               Used by dumpBinary() and restoreBinary() (FramI2CTools.h) on the device and by
+ *               the host tool extras/host/FramImageTransfer.cpp. Does not depend on Arduino.
+ *
+ *               A transfer starts with the 4 magic bytes "FRAM" (bytes received before the magic,
+ *               e.g. boot messages, are skipped), followed by frames. All fields are little-endian.
+ *
+ *               Frame:  type (1) | address (4) | length (2) | payload (length) | CRC-32 (4)
+ *                       The CRC-32 (FramI2CCrc) covers type up to and including the payload.
+ *
+ *               Types:  'H' Header  address: start address
+ *                                   payload: byte count (4), block size (2)
+ *                       'D' Data    address: FRAM address of the first payload byte
+ *                                   payload: block size bytes (less for the last block)
+ *                       'E' End     address: start address
+ *                                   payload: CRC-32 of the complete range (4)
+ *
+ *               Dump (device to host): magic, H, D..., E. Data frames are sent in address order.
+ *
+ *               Restore (host to device): magic, H with block size 0. The device replies Ack followed
+ *               by its block size (2), after which the host sends D... and E. The device replies to
+ *               every D and E frame with Ack, with Nak if the frame is corrupted (the frame is
+ *               sent again) or with Cancel followed by a FramI2C::ResultCode byte (transfer aborted).
+ *               A corrupted length field loses the frame boundary, so before sending Nak the device
+ *               discards input until nothing has been received for IdleMillis (the host is then
+ *               waiting for the reply).
+ *               Data is written to FRAM before the Ack is sent, E is acknowledged after the
+ *               range's CRC has been read back from FRAM and compared.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CTRANSFER_H_
+#define FRAMI2CTRANSFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FramI2CCrc.h"
+
+
+class FramI2CTransfer
+{
+
+public:
+
+    static const uint32_t Magic = 0x4D415246;      // "FRAM" little-endian
+    static const size_t MagicSize = 4;
+
+    static const uint8_t HeaderFrame = 'H';
+    static const uint8_t DataFrame = 'D';
+    static const uint8_t EndFrame = 'E';
+
+    static const uint8_t Ack = 0x06;
+    static const uint8_t Nak = 0x15;
+    static const uint8_t Cancel = 0x18;
+
+    static const size_t FrameHeaderSize = 7;        // type, address, length
+    static const size_t FrameCrcSize = 4;
+    static const size_t HeaderPayloadSize = 6;
+    static const size_t EndPayloadSize = 4;
+    static const size_t MaxBlockSize = 4096;        // Largest block size accepted by the host tool.
+    static const uint16_t IdleMillis = 50;          // Silence after which the device sends Nak.
+
+    // Block size used by the device (data bytes per frame).
+#if defined(__AVR__)
+    static const size_t BlockSize = 64;
+#else
+    static const size_t BlockSize = 256;
+#endif
+
+
+    static void encode16(uint8_t* const data, const uint16_t value)
+    {
+        data[0] = value & 0xFF;
+        data[1] = value >> 8;
+    }
+
+
+    static void encode32(uint8_t* const data, const uint32_t value)
+    {
+        data[0] = value & 0xFF;
+        data[1] = (value >> 8) & 0xFF;
+        data[2] = (value >> 16) & 0xFF;
+        data[3] = value >> 24;
+    }
+
+
+    static uint16_t decode16(const uint8_t* const data)
+    {
+        return static_cast<uint16_t>(data[0] | (data[1] << 8));
+    }
+
+
+    static uint32_t decode32(const uint8_t* const data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+            | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+
+    static void encodeFrameHeader(uint8_t* const data, const uint8_t type, const uint32_t address, const uint16_t length)
+    {
+        // Writes the FrameHeaderSize bytes that precede the payload.
+        data[0] = type;
+        encode32(data + 1, address);
+        encode16(data + 5, length);
+    }
+
+
+    static uint32_t frameCrc(const uint8_t* const frameHeader, const uint8_t* const payload, const size_t length)
+    {
+        // CRC-32 of a frame (frame header and payload may be stored separately).
+        FramI2CCrc crc(FramCrcAlgorithm::Crc32);
+        crc.update(frameHeader, FrameHeaderSize);
+        crc.update(payload, length);
+        return crc.value();
+    }
+};
+
+#endif  //FRAMI2CTRANSFER_H_
@@ -0,0 +1,103 @@
+/* FramI2CWireBus.h
+ *
+ * Description:  FramI2CBus adapter for the Arduino Wire library (TwoWire) and
+ *               for I2C drivers that have a Wire compatible interface.
+ *
+ *               Example usage (FRAM on second I2C bus):
+ *                 FramI2CWireBus framBus(Wire1);
+ *                 FramI2C fram;
+ *                 Wire1.begin();
+ *                 fram.begin(framBus, 64);
+ *
+ *               For a driver with Wire compatible interface but different class name:
+ *                 FramI2CWireBusT<i2c_t3> framBus(Wire, I2C_TX_BUFFER_LENGTH);
+ *
+ *               The size of the Wire library's I2C buffer is detected for common platforms.
+ *               If not detected (or if it was changed) it can be specified in the constructor.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMI2CWIREBUS_H_
+#define FRAMI2CWIREBUS_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "FramI2CBus.h"
+
+
+#if defined(I2C_BUFFER_LENGTH)
+    #define FRAMI2C_WIRE_BUFFER_LENGTH I2C_BUFFER_LENGTH        // ESP32
+#elif defined(BUFFER_LENGTH)
+    #define FRAMI2C_WIRE_BUFFER_LENGTH BUFFER_LENGTH            // AVR, ESP8266, STM32, Teensy
+#elif defined(WIRE_BUFFER_SIZE)
+    #define FRAMI2C_WIRE_BUFFER_LENGTH WIRE_BUFFER_SIZE         // RP2040 (arduino-pico)
+#elif defined(ARDUINO_ARCH_SAMD) && defined(SERIAL_BUFFER_SIZE)
+    #define FRAMI2C_WIRE_BUFFER_LENGTH SERIAL_BUFFER_SIZE       // SAMD (Wire uses RingBuffer)
+#else
+    #define FRAMI2C_WIRE_BUFFER_LENGTH 32
+#endif
+
+
+template<typename TWire> class FramI2CWireBusT : public FramI2CBus
+{
+
+public:
+
+    explicit FramI2CWireBusT(TWire& wire, const size_t bufferLength = FRAMI2C_WIRE_BUFFER_LENGTH)
+        : wire_(wire), bufferLength_(bufferLength)
+    {
+    }
+
+    size_t bufferLength(void) const override
+    {
+        return bufferLength_;
+    }
+
+    void beginTransmission(const uint8_t i2cAddress) override
+    {
+        wire_.beginTransmission(i2cAddress);
+    }
+
+    size_t write(const uint8_t value) override
+    {
+        return wire_.write(value);
+    }
+
+    size_t write(const uint8_t* const data, const size_t byteCount) override
+    {
+        return wire_.write(data, byteCount);
+    }
+
+    uint8_t endTransmission(const bool sendStop) override
+    {
+        return wire_.endTransmission(sendStop);
+    }
+
+    size_t requestFrom(const uint8_t i2cAddress, const size_t byteCount, const bool sendStop) override
+    {
+        return wire_.requestFrom(i2cAddress, byteCount, sendStop);
+    }
+
+    int read(void) override
+    {
+        return wire_.read();
+    }
+
+    size_t readBytes(uint8_t* const data, const size_t byteCount) override
+    {
+        return wire_.readBytes(data, byteCount);
+    }
+
+private:
+
+    TWire& wire_;
+    size_t bufferLength_;
+};
+
+
+typedef FramI2CWireBusT<TwoWire> FramI2CWireBus;
+
+#endif  //FRAMI2CWIREBUS_H_
@@ -0,0 +1,351 @@
+/* FramMirror.cpp
+ *
+ * Description:  FramMirror keeps two FRAM chips in sync (RAID-1 like).
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramMirror.h"
+
+
+// --- Public -----------------------------------------------------------------
+
+FramMirror::FramMirror()
+{
+    // Empty. All initialization is done in begin().
+}
+
+
+FramMirror::ResultCode FramMirror::begin(FramI2C& fram0, FramI2C& fram1)
+{
+    if (initialized_)
+    {
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (!fram0.isInitialized() || !fram1.isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+
+    frams_[0] = &fram0;
+    frams_[1] = &fram1;
+    memorySize_ = (fram0.memorySize() < fram1.memorySize()) ? fram0.memorySize() : fram1.memorySize();
+    regionSize_ = (memorySize_ + RegionCount - 1) / RegionCount;
+    for (uint8_t i = 0; i < ChipCount; ++i)
+    {
+        degraded_[i] = false;
+        memset(dirty_[i], 0, sizeof(dirty_[i]));
+    }
+    nextReadChip_ = 0;
+    initialized_ = true;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+void FramMirror::end(void)
+{
+    initialized_ = false;
+    memorySize_ = 0;
+    regionSize_ = 0;
+}
+
+
+bool FramMirror::isInitialized(void) const
+{
+    return initialized_;
+}
+
+
+uint32_t FramMirror::memorySize(void) const
+{
+    return memorySize_;
+}
+
+
+uint32_t FramMirror::regionSize(void) const
+{
+    return regionSize_;
+}
+
+
+bool FramMirror::isDegraded(const uint8_t chipIndex) const
+{
+    return (chipIndex < ChipCount) ? degraded_[chipIndex] : false;
+}
+
+
+bool FramMirror::isSynchronized(void) const
+{
+    return !degraded_[0] && !degraded_[1];
+}
+
+
+uint8_t FramMirror::dirtyRegionCount(const uint8_t chipIndex) const
+{
+    uint8_t count = 0;
+    if (chipIndex < ChipCount)
+    {
+        for (uint8_t region = 0; region < RegionCount; ++region)
+        {
+            count += isDirty(chipIndex, region) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+
+FramMirror::ResultCode FramMirror::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data)
+{
+    // Reads byteCount bytes starting at address into data.
+    // Reads alternate between both chips. If the read fails it is retried on the other chip,
+    // a chip that does not respond is marked degraded. A degraded chip is still read if none of
+    // the regions in the range is dirty (it then holds the current data), so that data remains
+    // readable when both chips are degraded (e.g. after a bus glitch).
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    const uint8_t firstChipIndex = nextReadChip_;
+    nextReadChip_ = (nextReadChip_ + 1) % ChipCount;
+    ResultCode resultcode = FramI2C::ResultCode::I2CAddressNackError;
+    bool tried[ChipCount] = {false, false};
+
+    // First pass: healthy chips, second pass: degraded chips whose range is not dirty.
+    for (uint8_t pass = 0; pass < 2; ++pass)
+    {
+        for (uint8_t i = 0; i < ChipCount; ++i)
+        {
+            const uint8_t chipIndex = (firstChipIndex + i) % ChipCount;
+            bool usable = (pass == 0) ? !degraded_[chipIndex] : !isRangeDirty(chipIndex, address, byteCount);
+            if (tried[chipIndex] || !usable)
+            {
+                continue;
+            }
+            tried[chipIndex] = true;
+            resultcode = frams_[chipIndex]->readBytes(address, byteCount, data);
+            if (resultcode == FramI2C::ResultCode::Success)
+            {
+                return resultcode;
+            }
+            if (resultcode == FramI2C::ResultCode::I2CAddressNackError)
+            {
+                degraded_[chipIndex] = true;
+            }
+        }
+    }
+    return resultcode;
+}
+
+
+FramMirror::ResultCode FramMirror::writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data)
+{
+    // Writes byteCount bytes from data starting at address to both chips.
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    return writeMirrored(address, byteCount, data, 0);
+}
+
+
+FramMirror::ResultCode FramMirror::fill(const uint32_t address, const size_t byteCount, const uint8_t value)
+{
+    // Fills byteCount bytes starting at address with value on both chips.
+    return writeMirrored(address, byteCount, nullptr, value);
+}
+
+
+FramMirror::ResultCode FramMirror::resync(const size_t maxByteCount)
+{
+    // A degraded chip is first probed, a chip that does not respond remains degraded.
+    // Its dirty regions are copied from the other chip, after which it is used again.
+    // When both chips are degraded, a region can be dirty on both chips (each missed a write);
+    // such regions are taken from chip 0.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    size_t bytesCopied = 0;
+    for (uint8_t chipIndex = 0; chipIndex < ChipCount; ++chipIndex)
+    {
+        if (!degraded_[chipIndex])
+        {
+            continue;
+        }
+        if (!isResponding(chipIndex))
+        {
+            resultcode = FramI2C::ResultCode::I2CAddressNackError;
+            continue;
+        }
+
+        const uint8_t sourceChipIndex = (chipIndex + 1) % ChipCount;
+        for (uint8_t region = 0; region < RegionCount; ++region)
+        {
+            if (!isDirty(chipIndex, region))
+            {
+                continue;
+            }
+            if (isDirty(sourceChipIndex, region))
+            {
+                // Dirty on both chips: chip 0 is kept, chip 1 is copied from chip 0 once chip 0 is clean.
+                if (chipIndex == 0)
+                {
+                    clearDirty(chipIndex, region);
+                }
+                continue;
+            }
+            if (maxByteCount > 0 && bytesCopied >= maxByteCount)
+            {
+                // Continue with the next region on the next call.
+                return FramI2C::ResultCode::Success;
+            }
+            ResultCode copyResultcode = copyRegion(sourceChipIndex, chipIndex, region);
+            if (copyResultcode != FramI2C::ResultCode::Success)
+            {
+                return copyResultcode;
+            }
+            clearDirty(chipIndex, region);
+            bytesCopied += regionSize_;
+        }
+
+        if (dirtyRegionCount(chipIndex) == 0)
+        {
+            // All dirty regions are copied and the chip responds, it is in sync again.
+            degraded_[chipIndex] = false;
+        }
+    }
+    return resultcode;
+}
+
+
+// --- Private ----------------------------------------------------------------
+
+FramMirror::ResultCode FramMirror::writeMirrored(const uint32_t address, const size_t byteCount, const uint8_t* const data, const uint8_t value)
+{
+    // Writes data (or fills with value if data is nullptr) to both chips.
+    // The write succeeds if it succeeds on at least one chip. A chip on which the write fails
+    // (for any reason, the chips then differ) or that is skipped because it is degraded, is marked
+    // degraded and the written range is marked dirty for that chip.
+    // Degraded chips are skipped, except when both chips are degraded: then both are tried,
+    // so that the mirror continues to work after a glitch that affected both chips.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((address >= memorySize_) || byteCount > (memorySize_ - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    const bool allDegraded = degraded_[0] && degraded_[1];
+    ResultCode failureResultcode = FramI2C::ResultCode::I2CAddressNackError;
+    bool written = false;
+    for (uint8_t chipIndex = 0; chipIndex < ChipCount; ++chipIndex)
+    {
+        bool chipWritten = false;
+        if (!degraded_[chipIndex] || allDegraded)
+        {
+            ResultCode chipResultcode = (data != nullptr) 
+                ? frams_[chipIndex]->writeBytes(address, byteCount, data) 
+                : frams_[chipIndex]->fill(address, byteCount, value);
+            chipWritten = chipResultcode == FramI2C::ResultCode::Success;
+            failureResultcode = chipWritten ? failureResultcode : chipResultcode;
+        }
+        if (!chipWritten)
+        {
+            degraded_[chipIndex] = true;
+            markDirty(chipIndex, address, byteCount);
+        }
+        written = written || chipWritten;
+    }
+    return written ? FramI2C::ResultCode::Success : failureResultcode;
+}
+
+
+void FramMirror::markDirty(const uint8_t chipIndex, const uint32_t address, const size_t byteCount)
+{
+    if (byteCount == 0)
+    {
+        return;
+    }
+    uint8_t lastRegion = (address + byteCount - 1) / regionSize_;
+    for (uint8_t region = address / regionSize_; region <= lastRegion; ++region)
+    {
+        dirty_[chipIndex][region / 8] |= (1 << (region % 8));
+    }
+}
+
+
+bool FramMirror::isRangeDirty(const uint8_t chipIndex, const uint32_t address, const size_t byteCount) const
+{
+    if (byteCount == 0)
+    {
+        return false;
+    }
+    uint8_t lastRegion = (address + byteCount - 1) / regionSize_;
+    for (uint8_t region = address / regionSize_; region <= lastRegion; ++region)
+    {
+        if (isDirty(chipIndex, region))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool FramMirror::isResponding(const uint8_t chipIndex) const
+{
+    // Probes the chip with a single byte read.
+    uint8_t value;
+    return frams_[chipIndex]->readBytes(static_cast<uint32_t>(0), 1, &value) == FramI2C::ResultCode::Success;
+}
+
+
+bool FramMirror::isDirty(const uint8_t chipIndex, const uint8_t region) const
+{
+    return (dirty_[chipIndex][region / 8] & (1 << (region % 8))) != 0;
+}
+
+
+void FramMirror::clearDirty(const uint8_t chipIndex, const uint8_t region)
+{
+    dirty_[chipIndex][region / 8] &= ~(1 << (region % 8));
+}
+
+
+FramMirror::ResultCode FramMirror::copyRegion(const uint8_t sourceChipIndex, const uint8_t destinationChipIndex, const uint8_t region) const
+{
+    uint8_t buffer[CopyBufferSize];
+    uint32_t address = region * regionSize_;
+    uint32_t endAddress = (address + regionSize_ < memorySize_) ? address + regionSize_ : memorySize_;
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    while (address < endAddress && resultcode == FramI2C::ResultCode::Success)
+    {
+        size_t byteCount = (endAddress - address < CopyBufferSize) ? endAddress - address : CopyBufferSize;
+        resultcode = frams_[sourceChipIndex]->readBytes(address, byteCount, buffer);
+        if (resultcode == FramI2C::ResultCode::Success)
+        {
+            resultcode = frams_[destinationChipIndex]->writeBytes(address, byteCount, buffer);
+        }
+        address += byteCount;
+    }
+    return resultcode;
+}
+
+
+/* eof */
@@ -0,0 +1,91 @@
+/* FramMirror.h
+ *
+ * Description:  FramMirror keeps two FRAM chips in sync (RAID-1 like).
+ *               Writes and fills go to both chips, reads alternate between the chips.
+ *               A chip that does not acknowledge its I2C address (I2CAddressNackError) or on which a write
+ *               fails is marked degraded and is no longer used. While a chip is degraded, the regions written
+ *               on the other chip are marked dirty. resync() probes the degraded chip and incrementally copies
+ *               only the dirty regions to it when it is available again. resync() can be called periodically
+ *               from loop() to resynchronize in the background. When both chips are degraded (e.g. after a bus
+ *               glitch) both are still tried, so the mirror recovers without end() and begin().
+ *
+ *               Example usage:
+ *                 FramI2C fram0;
+ *                 FramI2C fram1;
+ *                 FramMirror framMirror;
+ *                 fram0.begin(64, 0x50);
+ *                 fram1.begin(64, 0x51);
+ *                 framMirror.begin(fram0, fram1);
+ *                 ...
+ *                 void loop()
+ *                 {
+ *                     framMirror.resync(256);   // Copies max 256 bytes per call (if degraded).
+ *                 }
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMMIRROR_H_
+#define FRAMMIRROR_H_
+
+#include "FramI2C.h"
+
+
+class FramMirror
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    static const uint8_t ChipCount = 2;
+    static const uint8_t RegionCount = 64;     // Granularity of dirty region tracking.
+
+    FramMirror();
+
+    // Both FramI2C instances must be initialized. If the chips have different memory sizes,
+    // the memory size of the mirror is the memory size of the smallest chip.
+    ResultCode begin(FramI2C& fram0, FramI2C& fram1);
+    void end(void);
+
+    bool isInitialized(void) const;
+    uint32_t memorySize(void) const;
+    uint32_t regionSize(void) const;
+    bool isDegraded(const uint8_t chipIndex) const;
+    bool isSynchronized(void) const;
+    uint8_t dirtyRegionCount(const uint8_t chipIndex) const;
+
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data);
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data);
+    ResultCode fill(const uint32_t address, const size_t byteCount, const uint8_t value);
+
+    // Copies dirty regions from the other chip to a degraded chip that responds again.
+    // Copies at least one region and stops after maxByteCount bytes (0 = copy all dirty regions).
+    // Returns Success if there is nothing to copy or copying succeeded, I2CAddressNackError if a
+    // degraded chip still does not respond. When all dirty regions are copied the degraded chip is used again.
+    ResultCode resync(const size_t maxByteCount = 0);
+
+private:
+
+    static const size_t CopyBufferSize = 32;
+
+    FramI2C* frams_[ChipCount];
+    uint32_t memorySize_ = 0;
+    uint32_t regionSize_ = 0;
+    bool degraded_[ChipCount];
+    uint8_t dirty_[ChipCount][RegionCount / 8];
+    uint8_t nextReadChip_ = 0;
+    bool initialized_ = false;
+
+    ResultCode writeMirrored(const uint32_t address, const size_t byteCount, const uint8_t* const data, const uint8_t value);
+    void markDirty(const uint8_t chipIndex, const uint32_t address, const size_t byteCount);
+    bool isRangeDirty(const uint8_t chipIndex, const uint32_t address, const size_t byteCount) const;
+    bool isResponding(const uint8_t chipIndex) const;
+    bool isDirty(const uint8_t chipIndex, const uint8_t region) const;
+    void clearDirty(const uint8_t chipIndex, const uint8_t region);
+    ResultCode copyRegion(const uint8_t sourceChipIndex, const uint8_t destinationChipIndex, const uint8_t region) const;
+};
+
+#endif  //FRAMMIRROR_H_
@@ -0,0 +1,313 @@
+/* FramReadCache.cpp
+ *
+ * Description:  Read cache for FramI2C with least recently used replacement and sequential prefetch.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramReadCache.h"
+
+
+// --- Public -----------------------------------------------------------------
+
+FramReadCache::FramReadCache()
+{
+    // Empty. All initialization is done in begin().
+}
+
+
+FramReadCache::~FramReadCache()
+{
+    end();
+}
+
+
+FramReadCache::ResultCode FramReadCache::begin(FramI2C& fram, const uint8_t lineCount, const uint16_t lineSize, const bool prefetch)
+{
+    if (initialized_)
+    {
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (!fram.isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (fram.writeObserver() != nullptr)
+    {
+        // Only a single write observer is supported, replacing it would leave the other user with stale data.
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (lineCount == 0 || lineSize == 0)
+    {
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    lines_ = static_cast<Line*>(malloc(lineCount * sizeof(Line)));
+    data_ = static_cast<uint8_t*>(malloc(static_cast<size_t>(lineCount) * lineSize));
+    if (lines_ == nullptr || data_ == nullptr)
+    {
+        free(lines_);
+        free(data_);
+        lines_ = nullptr;
+        data_ = nullptr;
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    fram_ = &fram;
+    lineCount_ = lineCount;
+    lineSize_ = lineSize;
+    prefetch_ = prefetch;
+    invalidate();
+    resetStatistics();
+    fram.setWriteObserver(this);
+    initialized_ = true;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+void FramReadCache::end(void)
+{
+    if (fram_ != nullptr && fram_->writeObserver() == this)
+    {
+        fram_->setWriteObserver(nullptr);
+    }
+    free(lines_);
+    free(data_);
+    lines_ = nullptr;
+    data_ = nullptr;
+    fram_ = nullptr;
+    lineCount_ = 0;
+    lineSize_ = 0;
+    initialized_ = false;
+}
+
+
+bool FramReadCache::isInitialized(void) const
+{
+    return initialized_;
+}
+
+
+uint8_t FramReadCache::lineCount(void) const
+{
+    return lineCount_;
+}
+
+
+uint16_t FramReadCache::lineSize(void) const
+{
+    return lineSize_;
+}
+
+
+bool FramReadCache::prefetch(void) const
+{
+    return prefetch_;
+}
+
+
+void FramReadCache::setPrefetch(const bool enabled)
+{
+    prefetch_ = enabled;
+}
+
+
+const FramReadCache::Statistics& FramReadCache::statistics(void) const
+{
+    return statistics_;
+}
+
+
+void FramReadCache::resetStatistics(void)
+{
+    statistics_.hitCount = 0;
+    statistics_.missCount = 0;
+    statistics_.prefetchCount = 0;
+}
+
+
+FramReadCache::ResultCode FramReadCache::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data)
+{
+    // Reads byteCount bytes starting at address into data.
+    // Reads that are at least as large as the complete cache are read directly from FRAM
+    // (caching them would only replace all lines).
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= fram_->memorySize()) || byteCount > (fram_->memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    if (byteCount >= static_cast<size_t>(lineCount_) * lineSize_)
+    {
+        return fram_->readBytes(address, byteCount, data);
+    }
+
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0)
+    {
+        uint32_t tag = spanAddress - (spanAddress % lineSize_);
+        uint16_t offset = spanAddress - tag;
+        uint16_t spanSize = (totalBytesRemaining < static_cast<size_t>(lineSize_ - offset)) ? totalBytesRemaining : lineSize_ - offset;
+
+        Line* line = findLine(tag);
+        if (line != nullptr)
+        {
+            ++statistics_.hitCount;
+            line->lastUsed = ++useCounter_;
+        }
+        else
+        {
+            // A miss on the line that follows the previously accessed line is sequential:
+            // the next line is loaded ahead of use in the same FRAM read (a single I2C address phase).
+            ++statistics_.missCount;
+            const uint32_t nextTag = tag + lineSize_;
+            const bool prefetchNext = prefetch_ && lineCount_ > 1 && tag == nextSequentialTag_
+                && nextTag < fram_->memorySize() && findLine(nextTag) == nullptr;
+            uint8_t loadCount = prefetchNext ? 2 : 1;
+            ResultCode resultcode = loadLines(tag, loadCount, line);
+            if (resultcode != FramI2C::ResultCode::Success)
+            {
+                return resultcode;
+            }
+            if (loadCount == 2)
+            {
+                ++statistics_.prefetchCount;
+            }
+        }
+        memcpy(data + (spanAddress - address), lineData(line) + offset, spanSize);
+        nextSequentialTag_ = tag + lineSize_;
+
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+void FramReadCache::invalidate(void)
+{
+    for (uint8_t i = 0; i < lineCount_; ++i)
+    {
+        lines_[i].tag = NoTag;
+        lines_[i].lastUsed = 0;
+    }
+    nextSequentialTag_ = NoTag;
+}
+
+
+void FramReadCache::framWritten(const uint32_t address, const size_t byteCount)
+{
+    // Called by FramI2C before memory is written: invalidates all lines that overlap the written range.
+    const uint32_t endAddress = address + byteCount;
+    for (uint8_t i = 0; i < lineCount_; ++i)
+    {
+        if (lines_[i].tag != NoTag && lines_[i].tag < endAddress && address < lines_[i].tag + lineSize_)
+        {
+            lines_[i].tag = NoTag;
+        }
+    }
+}
+
+
+// --- Private ----------------------------------------------------------------
+
+FramReadCache::Line* FramReadCache::findLine(const uint32_t tag) const
+{
+    for (uint8_t i = 0; i < lineCount_; ++i)
+    {
+        if (lines_[i].tag == tag)
+        {
+            return &lines_[i];
+        }
+    }
+    return nullptr;
+}
+
+
+FramReadCache::ResultCode FramReadCache::loadLines(const uint32_t tag, uint8_t& count, Line*& line)
+{
+    // Reads count (1 or 2) consecutive lines starting at tag from FRAM with a single readBytes()
+    // into count adjacent cache lines. The least recently used line is replaced. A second line is
+    // only loaded if an adjacent slot is unused or holds the next least recently used line, so that
+    // prefetching never evicts a line that is more recently used; otherwise count is set to 1.
+    // line is set to the first line. The last line is shorter if the memory size is not a multiple
+    // of the line size.
+
+    uint8_t oldest = 0;
+    for (uint8_t i = 1; i < lineCount_; ++i)
+    {
+        if (lineAge(lines_[i]) < lineAge(lines_[oldest]))
+        {
+            oldest = i;
+        }
+    }
+    line = &lines_[oldest];
+
+    if (count == 2)
+    {
+        // Age of the next least recently used line. Unused lines have age 0 and are always eligible.
+        uint32_t nextOldestAge = NoTag;
+        for (uint8_t i = 0; i < lineCount_; ++i)
+        {
+            if (i != oldest && lineAge(lines_[i]) < nextOldestAge)
+            {
+                nextOldestAge = lineAge(lines_[i]);
+            }
+        }
+        const bool nextEligible = oldest + 1 < lineCount_ && lineAge(lines_[oldest + 1]) <= nextOldestAge;
+        const bool previousEligible = oldest > 0 && lineAge(lines_[oldest - 1]) <= nextOldestAge;
+        if (previousEligible && (!nextEligible || lineAge(lines_[oldest - 1]) < lineAge(lines_[oldest + 1])))
+        {
+            line = &lines_[oldest - 1];
+        }
+        else if (!nextEligible)
+        {
+            count = 1;
+        }
+    }
+
+    const uint32_t bytesToMemoryEnd = fram_->memorySize() - tag;
+    const size_t length = (bytesToMemoryEnd < static_cast<uint32_t>(count) * lineSize_) ? bytesToMemoryEnd : static_cast<size_t>(count) * lineSize_;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        line[i].tag = NoTag;
+    }
+    ResultCode resultcode = fram_->readBytes(tag, length, lineData(line));
+    if (resultcode == FramI2C::ResultCode::Success)
+    {
+        // Lines are marked used in reverse order, so that the first (accessed) line is most recently used.
+        for (uint8_t i = count; i-- > 0;)
+        {
+            line[i].tag = tag + static_cast<uint32_t>(i) * lineSize_;
+            line[i].lastUsed = ++useCounter_;
+        }
+    }
+    return resultcode;
+}
+
+
+uint32_t FramReadCache::lineAge(const Line& line) const
+{
+    // Value used to select the line to replace: lowest is least recently used, 0 for an unused line.
+    return (line.tag != NoTag) ? line.lastUsed : 0;
+}
+
+
+uint8_t* FramReadCache::lineData(const Line* const line) const
+{
+    return data_ + static_cast<size_t>(line - lines_) * lineSize_;
+}
+
+
+/* eof */
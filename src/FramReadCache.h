@@ -0,0 +1,112 @@
+/* FramReadCache.h
+ *
+ * Description:  Read cache for FramI2C.
+ *               Recently read FRAM memory is kept in cache lines in RAM. When all lines are in use the
+ *               least recently used line is replaced. Repeated reads of the same data (e.g. configuration
+ *               or lookup tables) are served from RAM without I2C transactions.
+ *
+ *               With prefetch enabled, a miss on the line that follows the previously accessed line
+ *               (sequential access) loads that line and the next line in a single FRAM read, so that
+ *               the next read is a cache hit and sequential reads need half the I2C address phases.
+ *               The next line only replaces an unused line or the next least recently used line, so
+ *               prefetching never evicts frequently used lines (the prefetch is skipped otherwise).
+ *
+ *               The cache registers itself as write observer of the FramI2C instance: writes and fills
+ *               made via the FramI2C instance (also via FramArray and FramStripe) invalidate the affected
+ *               cache lines, so the cache never returns stale data.
+ *
+ *               Example usage:
+ *                 FramI2C fram;
+ *                 FramReadCache cache;
+ *                 fram.begin(64);
+ *                 cache.begin(fram, 4, 32);   // 4 lines of 32 bytes.
+ *                 ...
+ *                 cache.read(0x10, setpoint);
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMREADCACHE_H_
+#define FRAMREADCACHE_H_
+
+#include "FramI2C.h"
+
+
+class FramReadCache : public FramI2CWriteObserver
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    struct Statistics
+    {
+        uint32_t hitCount;          // Number of line accesses served from the cache.
+        uint32_t missCount;         // Number of line accesses that required reading FRAM.
+        uint32_t prefetchCount;     // Number of lines loaded ahead of use.
+    };
+
+    FramReadCache();
+    ~FramReadCache();
+
+    // fram must be initialized and must not have a write observer. The cache becomes fram's write observer.
+    // Returns AllreadyInitializedError if fram already has a write observer (e.g. another cache).
+    ResultCode begin(FramI2C& fram, const uint8_t lineCount = 4, const uint16_t lineSize = 32, const bool prefetch = true);
+    void end(void);
+
+    bool isInitialized(void) const;
+    uint8_t lineCount(void) const;
+    uint16_t lineSize(void) const;
+    bool prefetch(void) const;
+    void setPrefetch(const bool enabled);
+    const Statistics& statistics(void) const;
+    void resetStatistics(void);
+
+    // Linear addressing, see FramI2C.
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data);
+
+    // Discards all cached data.
+    void invalidate(void);
+
+    void framWritten(const uint32_t address, const size_t byteCount) override;
+
+
+    template<typename T> ResultCode read(const uint32_t address, T& t)
+    {
+        // Generic read method, see FramI2C.
+        // If the read fails the value of t is undefined.
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        return readBytes(address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
+    }
+
+
+private:
+
+    static const uint32_t NoTag = 0xFFFFFFFF;
+
+    struct Line
+    {
+        uint32_t tag;           // FRAM address of the first byte of the line (NoTag if unused).
+        uint32_t lastUsed;      // Value of useCounter_ at last access, lowest is least recently used.
+    };
+
+    FramI2C* fram_ = nullptr;
+    Line* lines_ = nullptr;
+    uint8_t* data_ = nullptr;           // lineCount_ * lineSize_ bytes.
+    uint8_t lineCount_ = 0;
+    uint16_t lineSize_ = 0;
+    bool prefetch_ = false;
+    uint32_t useCounter_ = 0;
+    uint32_t nextSequentialTag_ = NoTag;    // Tag of the line that follows the last missed line.
+    Statistics statistics_ = {0, 0, 0};
+    bool initialized_ = false;
+
+    Line* findLine(const uint32_t tag) const;
+    ResultCode loadLines(const uint32_t tag, uint8_t& count, Line*& line);
+    uint32_t lineAge(const Line& line) const;
+    uint8_t* lineData(const Line* const line) const;
+};
+
+#endif  //FRAMREADCACHE_H_
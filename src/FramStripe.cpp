@@ -0,0 +1,313 @@
+/* FramStripe.cpp
+ *
+ * Description:  FramStripe combines multiple FRAM chips into a single striped (RAID-0 like) linear address space.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramStripe.h"
+
+
+// --- Public -----------------------------------------------------------------
+
+FramStripe::FramStripe()
+{
+    // Empty. All initialization is done in begin().
+}
+
+
+FramStripe::~FramStripe()
+{
+    end();
+}
+
+
+FramStripe::ResultCode FramStripe::begin(FramI2C* const frams[], const uint8_t framCount, const uint16_t stripeSize)
+{
+    if (initialized_)
+    {
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (frams == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if (framCount == 0 || framCount > MaxChipCount)
+    {
+        return FramI2C::ResultCode::InvalidChipCountError;
+    }
+
+    uint32_t chipMemorySize = 0;
+    uint8_t busCount = 0;
+    for (uint8_t i = 0; i < framCount; ++i)
+    {
+        if (frams[i] == nullptr)
+        {
+            return FramI2C::ResultCode::NullPtrError;
+        }
+        if (!frams[i]->isInitialized())
+        {
+            return FramI2C::ResultCode::NotInitializedError;
+        }
+        if (i == 0 || frams[i]->memorySize() < chipMemorySize)
+        {
+            chipMemorySize = frams[i]->memorySize();
+        }
+
+        // Chips that are connected to the same bus get the same bus index.
+        uint8_t busIndex = busCount;
+        for (uint8_t j = 0; j < i; ++j)
+        {
+            if (frams[j]->bus_ == frams[i]->bus_)
+            {
+                busIndex = chipBusIndex_[j];
+                break;
+            }
+        }
+        if (busIndex == busCount)
+        {
+            ++busCount;
+        }
+        frams_[i] = frams[i];
+        chipBusIndex_[i] = busIndex;
+    }
+
+    if (stripeSize == 0 || stripeSize > chipMemorySize)
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+#if defined(FRAMSTRIPE_CONCURRENT)
+    for (uint8_t i = 1; i < busCount; ++i)
+    {
+        Worker& worker = workers_[i];
+        worker.stripe = this;
+        worker.busIndex = i;
+        worker.start = xSemaphoreCreateBinary();
+        worker.done = xSemaphoreCreateBinary();
+        worker.task = nullptr;
+        if (worker.start == nullptr || worker.done == nullptr
+            || xTaskCreate(workerTask, "FramStripe", FRAMSTRIPE_WORKER_STACK_SIZE, &worker, uxTaskPriorityGet(nullptr), &worker.task) != pdPASS)
+        {
+            busCount_ = i + 1;
+            end();
+            return FramI2C::ResultCode::BufferAllocationFailedError;
+        }
+    }
+#endif
+
+    chipCount_ = framCount;
+    busCount_ = busCount;
+    stripeSize_ = stripeSize;
+    chipMemorySize_ = chipMemorySize - (chipMemorySize % stripeSize);
+    initialized_ = true;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+void FramStripe::end(void)
+{
+#if defined(FRAMSTRIPE_CONCURRENT)
+    for (uint8_t i = 1; i < busCount_; ++i)
+    {
+        Worker& worker = workers_[i];
+        if (worker.task != nullptr)
+        {
+            vTaskDelete(worker.task);
+            worker.task = nullptr;
+        }
+        if (worker.start != nullptr)
+        {
+            vSemaphoreDelete(worker.start);
+            worker.start = nullptr;
+        }
+        if (worker.done != nullptr)
+        {
+            vSemaphoreDelete(worker.done);
+            worker.done = nullptr;
+        }
+    }
+#endif
+    initialized_ = false;
+    chipCount_ = 0;
+    busCount_ = 0;
+    stripeSize_ = 0;
+    chipMemorySize_ = 0;
+}
+
+
+bool FramStripe::isInitialized(void) const
+{
+    return initialized_;
+}
+
+
+uint8_t FramStripe::chipCount(void) const
+{
+    return chipCount_;
+}
+
+
+uint8_t FramStripe::busCount(void) const
+{
+    return busCount_;
+}
+
+
+uint16_t FramStripe::stripeSize(void) const
+{
+    return stripeSize_;
+}
+
+
+uint32_t FramStripe::memorySize(void) const
+{
+    return chipMemorySize_ * chipCount_;
+}
+
+
+FramStripe::ResultCode FramStripe::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data)
+{
+    // Reads byteCount bytes starting at address into data.
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    return transfer(Operation::Read, address, byteCount, data, 0);
+}
+
+
+FramStripe::ResultCode FramStripe::writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data)
+{
+    // Writes byteCount bytes from data starting at address.
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    // data is only read from for Operation::Write.
+    return transfer(Operation::Write, address, byteCount, const_cast<uint8_t*>(data), 0);
+}
+
+
+FramStripe::ResultCode FramStripe::fill(const uint32_t address, const size_t byteCount, const uint8_t value)
+{
+    // Fills byteCount bytes starting at address with value.
+    return transfer(Operation::Fill, address, byteCount, nullptr, value);
+}
+
+
+// --- Private ----------------------------------------------------------------
+
+FramStripe::ResultCode FramStripe::transfer(const Operation operation, const uint32_t address, const size_t byteCount, uint8_t* const data, const uint8_t value)
+{
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if ((address >= memorySize()) || byteCount > (memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    request_.operation = operation;
+    request_.address = address;
+    request_.byteCount = byteCount;
+    request_.data = data;
+    request_.value = value;
+
+#if defined(FRAMSTRIPE_CONCURRENT)
+    // Start the workers for the other buses, transfer bus 0 in the calling task, then wait for the workers.
+    for (uint8_t i = 1; i < busCount_; ++i)
+    {
+        xSemaphoreGive(workers_[i].start);
+    }
+    ResultCode resultcode = transferBus(0);
+    for (uint8_t i = 1; i < busCount_; ++i)
+    {
+        xSemaphoreTake(workers_[i].done, portMAX_DELAY);
+        if (resultcode == FramI2C::ResultCode::Success)
+        {
+            resultcode = workers_[i].resultcode;
+        }
+    }
+#else
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    for (uint8_t i = 0; i < busCount_ && resultcode == FramI2C::ResultCode::Success; ++i)
+    {
+        resultcode = transferBus(i);
+    }
+#endif
+    return resultcode;
+}
+
+
+FramStripe::ResultCode FramStripe::transferBus(const uint8_t busIndex) const
+{
+    // Transfers the parts of the current request that are stored on the chips connected to bus busIndex.
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    for (uint8_t i = 0; i < chipCount_ && resultcode == FramI2C::ResultCode::Success; ++i)
+    {
+        if (chipBusIndex_[i] == busIndex)
+        {
+            resultcode = transferChip(i);
+        }
+    }
+    return resultcode;
+}
+
+
+FramStripe::ResultCode FramStripe::transferChip(const uint8_t chipIndex) const
+{
+    // Transfers the stripes of the current request that are stored on chip chipIndex.
+    // Stripe s is stored on chip (s % chipCount) at chip address (s / chipCount) * stripeSize.
+
+    const FramI2C* fram = frams_[chipIndex];
+    const uint32_t endAddress = request_.address + request_.byteCount;
+    uint32_t firstStripe = request_.address / stripeSize_;
+    uint32_t stripe = firstStripe + (chipIndex + chipCount_ - (firstStripe % chipCount_)) % chipCount_;
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    while (stripe * stripeSize_ < endAddress && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint32_t stripeAddress = stripe * stripeSize_;
+        uint32_t partAddress = (request_.address > stripeAddress) ? request_.address : stripeAddress;
+        uint32_t partEndAddress = (endAddress < stripeAddress + stripeSize_) ? endAddress : stripeAddress + stripeSize_;
+        uint32_t chipAddress = (stripe / chipCount_) * stripeSize_ + (partAddress - stripeAddress);
+        size_t partSize = partEndAddress - partAddress;
+
+        switch (request_.operation)
+        {
+            case Operation::Read:
+                resultcode = fram->readBytes(chipAddress, partSize, request_.data + (partAddress - request_.address));
+                break;
+            case Operation::Write:
+                resultcode = fram->writeBytes(chipAddress, partSize, request_.data + (partAddress - request_.address));
+                break;
+            case Operation::Fill:
+                resultcode = fram->fill(chipAddress, partSize, request_.value);
+                break;
+        }
+        stripe += chipCount_;
+    }
+    return resultcode;
+}
+
+
+#if defined(FRAMSTRIPE_CONCURRENT)
+void FramStripe::workerTask(void* parameter)
+{
+    Worker* worker = static_cast<Worker*>(parameter);
+    for (;;)
+    {
+        xSemaphoreTake(worker->start, portMAX_DELAY);
+        worker->resultcode = worker->stripe->transferBus(worker->busIndex);
+        xSemaphoreGive(worker->done);
+    }
+}
+#endif
+
+
+/* eof */
@@ -0,0 +1,128 @@
+/* FramStripe.h
+ *
+ * Description:  FramStripe combines multiple FRAM chips (up to 8) into a single striped (RAID-0 like)
+ *               linear address space. Consecutive stripes of stripeSize bytes are interleaved over the chips:
+ *               stripe 0 is stored on chip 0, stripe 1 on chip 1, etc.
+ *
+ *               When the chips are connected to different I2C buses (e.g. Wire and Wire1) the transfers
+ *               on the different buses are performed concurrently, with a FreeRTOS task per additional bus:
+ *               on ESP32, and on RP2040 (arduino-pico) when FreeRTOS is enabled (Tools > Operating System >
+ *               FreeRTOS SMP), where the tasks can run on the second core. On all other platforms, and
+ *               on RP2040 without FreeRTOS, the buses are accessed one after the other, which is functionally
+ *               identical but does not increase throughput. FRAMSTRIPE_CONCURRENT is defined when the
+ *               buses are accessed concurrently.
+ *
+ *               Example usage (two 256 kb FRAM chips on two I2C buses):
+ *                 FramI2CWireBus framBus0(Wire);
+ *                 FramI2CWireBus framBus1(Wire1);
+ *                 FramI2C fram0;
+ *                 FramI2C fram1;
+ *                 FramStripe framStripe;
+ *                 fram0.begin(framBus0, 256);
+ *                 fram1.begin(framBus1, 256);
+ *                 FramI2C* frams[] = {&fram0, &fram1};
+ *                 framStripe.begin(frams, 2, 256);
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMSTRIPE_H_
+#define FRAMSTRIPE_H_
+
+#include "FramI2C.h"
+
+#if defined(ESP32)
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+    #include <freertos/semphr.h>
+    #define FRAMSTRIPE_CONCURRENT
+    #define FRAMSTRIPE_WORKER_STACK_SIZE 2048               // Bytes on ESP32.
+#elif defined(ARDUINO_ARCH_RP2040) && defined(__FREERTOS)
+    #include <FreeRTOS.h>
+    #include <task.h>
+    #include <semphr.h>
+    #define FRAMSTRIPE_CONCURRENT
+    #define FRAMSTRIPE_WORKER_STACK_SIZE 512                // Words (2 KB) in standard FreeRTOS.
+#endif
+
+
+class FramStripe
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    static const uint8_t MaxChipCount = 8;
+
+    FramStripe();
+    ~FramStripe();
+
+    // frams contains framCount pointers to initialized FramI2C instances.
+    // Chips that share the same bus are accessed sequentially, chips on different buses concurrently.
+    // The usable memory size per chip is the memory size of the smallest chip, rounded down to stripeSize.
+    ResultCode begin(FramI2C* const frams[], const uint8_t framCount, const uint16_t stripeSize);
+    void end(void);
+
+    bool isInitialized(void) const;
+    uint8_t chipCount(void) const;
+    uint8_t busCount(void) const;
+    uint16_t stripeSize(void) const;
+    uint32_t memorySize(void) const;
+
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data);
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data);
+    ResultCode fill(const uint32_t address, const size_t byteCount, const uint8_t value);
+
+private:
+
+    enum class Operation : uint8_t
+    {
+        Read,
+        Write,
+        Fill
+    };
+
+    struct Request
+    {
+        Operation operation;
+        uint32_t address;
+        size_t byteCount;
+        uint8_t* data;
+        uint8_t value;
+    };
+
+    FramI2C* frams_[MaxChipCount];
+    uint8_t chipBusIndex_[MaxChipCount];    // Index of the bus that each chip is connected to.
+    uint8_t chipCount_ = 0;
+    uint8_t busCount_ = 0;
+    uint16_t stripeSize_ = 0;
+    uint32_t chipMemorySize_ = 0;
+    bool initialized_ = false;
+    Request request_;
+
+    ResultCode transfer(const Operation operation, const uint32_t address, const size_t byteCount, uint8_t* const data, const uint8_t value);
+    ResultCode transferBus(const uint8_t busIndex) const;
+    ResultCode transferChip(const uint8_t chipIndex) const;
+
+#if defined(FRAMSTRIPE_CONCURRENT)
+    struct Worker
+    {
+        FramStripe* stripe;
+        uint8_t busIndex;
+        TaskHandle_t task;
+        SemaphoreHandle_t start;
+        SemaphoreHandle_t done;
+        ResultCode resultcode;
+    };
+
+    // Worker tasks for buses 1 to busCount_ - 1, bus 0 is handled by the calling task.
+    Worker workers_[MaxChipCount];
+
+    static void workerTask(void* parameter);
+#endif
+};
+
+#endif  //FRAMSTRIPE_H_
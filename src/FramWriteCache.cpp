@@ -0,0 +1,464 @@
+/* FramWriteCache.cpp
+ *
+ * Description:  Write-back RAM cache for FramI2C.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramWriteCache.h"
+
+
+// --- Public -----------------------------------------------------------------
+
+FramWriteCache::FramWriteCache()
+{
+    // Empty. All initialization is done in begin().
+}
+
+
+FramWriteCache::~FramWriteCache()
+{
+    // Dirty data must not be lost when the cache goes out of scope: end() flushes it first.
+    end();
+}
+
+
+FramWriteCache::ResultCode FramWriteCache::begin(FramI2C& fram, const uint8_t lineCount, const uint16_t lineSize, const uint32_t flushIntervalMs)
+{
+    if (initialized_)
+    {
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (!fram.isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (lineCount == 0 || lineSize == 0)
+    {
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    chunkSize_ = fram.i2cBufferLength() - fram.addressBytesCount();
+    lines_ = static_cast<Line*>(malloc(lineCount * sizeof(Line)));
+    data_ = static_cast<uint8_t*>(malloc(static_cast<size_t>(lineCount) * lineSize));
+    chunkBuffer_ = static_cast<uint8_t*>(malloc(chunkSize_));
+    if (lines_ == nullptr || data_ == nullptr || chunkBuffer_ == nullptr)
+    {
+        free(lines_);
+        free(data_);
+        free(chunkBuffer_);
+        lines_ = nullptr;
+        data_ = nullptr;
+        chunkBuffer_ = nullptr;
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    for (uint8_t i = 0; i < lineCount; ++i)
+    {
+        lines_[i].tag = NoTag;
+        lines_[i].dirtyStart = 0;
+        lines_[i].dirtyEnd = 0;
+    }
+    fram_ = &fram;
+    lineCount_ = lineCount;
+    lineSize_ = lineSize;
+    flushIntervalMs_ = flushIntervalMs;
+    timerStarted_ = false;
+    resetStatistics();
+    initialized_ = true;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+FramWriteCache::ResultCode FramWriteCache::end(void)
+{
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::Success;
+    }
+
+    ResultCode resultcode = flush();
+    free(lines_);
+    free(data_);
+    free(chunkBuffer_);
+    lines_ = nullptr;
+    data_ = nullptr;
+    chunkBuffer_ = nullptr;
+    fram_ = nullptr;
+    lineCount_ = 0;
+    lineSize_ = 0;
+    initialized_ = false;
+    return resultcode;
+}
+
+
+bool FramWriteCache::isInitialized(void) const
+{
+    return initialized_;
+}
+
+
+uint8_t FramWriteCache::lineCount(void) const
+{
+    return lineCount_;
+}
+
+
+uint16_t FramWriteCache::lineSize(void) const
+{
+    return lineSize_;
+}
+
+
+uint8_t FramWriteCache::dirtyLineCount(void) const
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < lineCount_; ++i)
+    {
+        count += (lines_[i].dirtyEnd > lines_[i].dirtyStart) ? 1 : 0;
+    }
+    return count;
+}
+
+
+const FramWriteCache::Statistics& FramWriteCache::statistics(void) const
+{
+    return statistics_;
+}
+
+
+void FramWriteCache::resetStatistics(void)
+{
+    statistics_.writeCount = 0;
+    statistics_.flushCount = 0;
+    statistics_.busTransactionCount = 0;
+}
+
+
+FramWriteCache::ResultCode FramWriteCache::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data)
+{
+    // Reads byteCount bytes starting at address into data.
+    // Data is read from FRAM and overlaid with the dirty (not yet flushed) data in the cache.
+    // If the range is completely dirty in a single cache line FRAM is not accessed.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+
+    const uint32_t endAddress = address + byteCount;
+    Line* line = findLine(address - (address % lineSize_));
+    bool cached = line != nullptr 
+        && address >= line->tag + line->dirtyStart 
+        && endAddress <= line->tag + line->dirtyEnd;
+
+    if (!cached)
+    {
+        ResultCode resultcode = fram_->readBytes(address, byteCount, data);
+        if (resultcode != FramI2C::ResultCode::Success)
+        {
+            return resultcode;
+        }
+    }
+
+    for (uint8_t i = 0; i < lineCount_; ++i)
+    {
+        const Line& cacheLine = lines_[i];
+        if (cacheLine.dirtyEnd <= cacheLine.dirtyStart)
+        {
+            continue;
+        }
+        uint32_t dirtyStartAddress = cacheLine.tag + cacheLine.dirtyStart;
+        uint32_t dirtyEndAddress = cacheLine.tag + cacheLine.dirtyEnd;
+        uint32_t overlapStart = (address > dirtyStartAddress) ? address : dirtyStartAddress;
+        uint32_t overlapEnd = (endAddress < dirtyEndAddress) ? endAddress : dirtyEndAddress;
+        if (overlapStart < overlapEnd)
+        {
+            memcpy(data + (overlapStart - address), lineData(&cacheLine) + (overlapStart - cacheLine.tag), overlapEnd - overlapStart);
+        }
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+FramWriteCache::ResultCode FramWriteCache::writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data)
+{
+    // Writes byteCount bytes from data starting at address into the cache.
+    // If no cache line is available the cache is flushed first.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= fram_->memorySize()) || byteCount > (fram_->memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+
+    ++statistics_.writeCount;
+    uint32_t spanAddress = address;
+    size_t totalBytesRemaining = byteCount;
+    while (totalBytesRemaining > 0)
+    {
+        uint32_t tag = spanAddress - (spanAddress % lineSize_);
+        uint16_t offset = spanAddress - tag;
+        uint16_t spanSize = (totalBytesRemaining < static_cast<size_t>(lineSize_ - offset)) ? totalBytesRemaining : lineSize_ - offset;
+
+        Line* line = findLine(tag);
+        if (line == nullptr)
+        {
+            line = allocateLine(tag);
+            if (line == nullptr)
+            {
+                // Cache is full.
+                ResultCode resultcode = flush();
+                if (resultcode != FramI2C::ResultCode::Success)
+                {
+                    return resultcode;
+                }
+                line = allocateLine(tag);
+            }
+        }
+
+        uint8_t* lineBytes = lineData(line);
+        if (line->dirtyEnd <= line->dirtyStart)
+        {
+            line->dirtyStart = offset;
+            line->dirtyEnd = offset + spanSize;
+        }
+        else
+        {
+            // The dirty range is kept contiguous. If there is a gap between the current dirty range
+            // and the new data, the gap is filled with the data from FRAM.
+            uint16_t gapStart = 0;
+            uint16_t gapEnd = 0;
+            if (offset > line->dirtyEnd)
+            {
+                gapStart = line->dirtyEnd;
+                gapEnd = offset;
+            }
+            else if (offset + spanSize < line->dirtyStart)
+            {
+                gapStart = offset + spanSize;
+                gapEnd = line->dirtyStart;
+            }
+            if (gapEnd > gapStart)
+            {
+                ResultCode resultcode = fram_->readBytes(tag + gapStart, gapEnd - gapStart, lineBytes + gapStart);
+                if (resultcode != FramI2C::ResultCode::Success)
+                {
+                    return resultcode;
+                }
+                statistics_.busTransactionCount += (gapEnd - gapStart + fram_->i2cBufferLength() - 1) / fram_->i2cBufferLength();
+            }
+            line->dirtyStart = (offset < line->dirtyStart) ? offset : line->dirtyStart;
+            line->dirtyEnd = (offset + spanSize > line->dirtyEnd) ? offset + spanSize : line->dirtyEnd;
+        }
+        memcpy(lineBytes + offset, data + (spanAddress - address), spanSize);
+        if (!timerStarted_)
+        {
+            // The flush interval starts when the cache becomes dirty.
+            timerStarted_ = true;
+            dirtySinceMillis_ = currentMillis();
+        }
+
+        spanAddress += spanSize;
+        totalBytesRemaining -= spanSize;
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+FramWriteCache::ResultCode FramWriteCache::flush(void)
+{
+    // Writes all dirty data to FRAM. Dirty ranges of cache lines with consecutive addresses
+    // that connect (end of line dirty and start of next line dirty) are merged into a single run,
+    // which is written in maximum size I2C chunks.
+
+    if (!initialized_ || !fram_->isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+
+    timerStarted_ = false;
+    bool flushed = false;
+    for (;;)
+    {
+        // Find the dirty line with the lowest address.
+        Line* first = nullptr;
+        for (uint8_t i = 0; i < lineCount_; ++i)
+        {
+            Line* line = &lines_[i];
+            if (line->dirtyEnd > line->dirtyStart && (first == nullptr || line->tag < first->tag))
+            {
+                first = line;
+            }
+        }
+        if (first == nullptr)
+        {
+            break;
+        }
+
+        uint32_t runStart = first->tag + first->dirtyStart;
+        Line* last = first;
+        Line* next = nullptr;
+        while (last->dirtyEnd == lineSize_ 
+            && (next = findLine(last->tag + lineSize_)) != nullptr 
+            && next->dirtyStart == 0 && next->dirtyEnd > 0)
+        {
+            last = next;
+        }
+        uint32_t runEnd = last->tag + last->dirtyEnd;
+
+        ResultCode resultcode = writeRun(runStart, runEnd);
+        if (resultcode != FramI2C::ResultCode::Success)
+        {
+            return resultcode;
+        }
+        for (uint32_t tag = first->tag; tag <= last->tag; tag += lineSize_)
+        {
+            Line* line = findLine(tag);
+            line->dirtyStart = 0;
+            line->dirtyEnd = 0;
+        }
+        flushed = true;
+    }
+    if (flushed)
+    {
+        ++statistics_.flushCount;
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+FramWriteCache::ResultCode FramWriteCache::poll(const uint32_t currentMillis)
+{
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    lastPollMillis_ = currentMillis;
+    if (flushIntervalMs_ == 0 || dirtyLineCount() == 0)
+    {
+        return FramI2C::ResultCode::Success;
+    }
+    if (!timerStarted_)
+    {
+        // Only if a flush failed and left dirty lines.
+        timerStarted_ = true;
+        dirtySinceMillis_ = currentMillis;
+        return FramI2C::ResultCode::Success;
+    }
+    if (currentMillis - dirtySinceMillis_ >= flushIntervalMs_)
+    {
+        return flush();
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+#if defined(ARDUINO)
+FramWriteCache::ResultCode FramWriteCache::poll(void)
+{
+    return poll(millis());
+}
+#endif
+
+
+// --- Private ----------------------------------------------------------------
+
+FramWriteCache::Line* FramWriteCache::findLine(const uint32_t tag) const
+{
+    for (uint8_t i = 0; i < lineCount_; ++i)
+    {
+        if (lines_[i].tag == tag)
+        {
+            return &lines_[i];
+        }
+    }
+    return nullptr;
+}
+
+
+FramWriteCache::Line* FramWriteCache::allocateLine(const uint32_t tag)
+{
+    // Returns an unused or clean line (or nullptr if all lines are dirty).
+    for (uint8_t i = 0; i < lineCount_; ++i)
+    {
+        if (lines_[i].dirtyEnd <= lines_[i].dirtyStart)
+        {
+            lines_[i].tag = tag;
+            lines_[i].dirtyStart = 0;
+            lines_[i].dirtyEnd = 0;
+            return &lines_[i];
+        }
+    }
+    return nullptr;
+}
+
+
+uint32_t FramWriteCache::currentMillis(void) const
+{
+    // Time at which the cache becomes dirty. Without Arduino's millis() the time of the last poll()
+    // is used, so a timed flush is never later than the flush interval after the write.
+#if defined(ARDUINO)
+    return millis();
+#else
+    return lastPollMillis_;
+#endif
+}
+
+
+uint8_t* FramWriteCache::lineData(const Line* const line) const
+{
+    return data_ + static_cast<size_t>(line - lines_) * lineSize_;
+}
+
+
+FramWriteCache::ResultCode FramWriteCache::writeRun(const uint32_t address, const uint32_t endAddress)
+{
+    // Writes the cached data from address up to endAddress in chunks that fit a single I2C transaction.
+    // Chunks do not cross page boundaries (which would require an extra transaction).
+
+    ResultCode resultcode = FramI2C::ResultCode::Success;
+    uint32_t chunkAddress = address;
+    while (chunkAddress < endAddress && resultcode == FramI2C::ResultCode::Success)
+    {
+        uint32_t bytesRemaining = endAddress - chunkAddress;
+        uint32_t bytesToPageEnd = fram_->pageSize() - (chunkAddress % fram_->pageSize());
+        size_t chunkSize = (bytesRemaining < chunkSize_) ? static_cast<size_t>(bytesRemaining) : chunkSize_;
+        chunkSize = (chunkSize < bytesToPageEnd) ? chunkSize : static_cast<size_t>(bytesToPageEnd);
+
+        // Gather the chunk from the cache lines.
+        size_t copied = 0;
+        while (copied < chunkSize)
+        {
+            uint32_t byteAddress = chunkAddress + copied;
+            uint32_t tag = byteAddress - (byteAddress % lineSize_);
+            uint16_t offset = byteAddress - tag;
+            size_t count = lineSize_ - offset;
+            count = (count < chunkSize - copied) ? count : chunkSize - copied;
+            memcpy(chunkBuffer_ + copied, lineData(findLine(tag)) + offset, count);
+            copied += count;
+        }
+
+        resultcode = fram_->writeBytes(chunkAddress, chunkSize, chunkBuffer_);
+        ++statistics_.busTransactionCount;
+        chunkAddress += chunkSize;
+    }
+    return resultcode;
+}
+
+
+/* eof */
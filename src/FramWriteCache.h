@@ -0,0 +1,137 @@
+/* FramWriteCache.h
+ *
+ * Description:  Write-back RAM cache for FramI2C.
+ *               Writes are stored in cache lines in RAM and are only written to FRAM when the cache
+ *               is flushed: by calling flush(), when the flush interval has elapsed (see poll()),
+ *               or when the cache is full. Repeated writes to the same locations are absorbed by the cache.
+ *               On flush, dirty ranges of adjacent cache lines are merged and written with as few
+ *               (maximum size) I2C transactions as possible.
+ *
+ *               Data that is written via the cache must also be read via the cache (readBytes/read),
+ *               which returns the cached (not yet flushed) data.
+ *
+ *               Example usage:
+ *                 FramI2C fram;
+ *                 FramWriteCache cache;
+ *                 fram.begin(64);
+ *                 cache.begin(fram, 8, 32, 100);   // 8 lines of 32 bytes, flush every 100 ms.
+ *                 ...
+ *                 void loop()
+ *                 {
+ *                     cache.write(0x10, setpoint);
+ *                     cache.poll();
+ *                 }
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMWRITECACHE_H_
+#define FRAMWRITECACHE_H_
+
+#include "FramI2C.h"
+
+
+class FramWriteCache
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    struct Statistics
+    {
+        uint32_t writeCount;            // Number of write calls.
+        uint32_t flushCount;            // Number of flushes.
+        uint32_t busTransactionCount;   // Number of I2C write (and read) transactions issued to FRAM.
+
+        // Number of I2C transactions saved compared to writing every write directly to FRAM.
+        uint32_t savedTransactionCount(void) const
+        {
+            return (writeCount > busTransactionCount) ? writeCount - busTransactionCount : 0;
+        }
+    };
+
+    FramWriteCache();
+    ~FramWriteCache();
+
+    // fram must be initialized. flushIntervalMs is the maximum time that data is kept
+    // in the cache before poll() flushes it (0 = no timed flush).
+    ResultCode begin(FramI2C& fram, const uint8_t lineCount = 8, const uint16_t lineSize = 32, const uint32_t flushIntervalMs = 0);
+
+    // Flushes the cache and frees the allocated memory. The destructor calls end(), so dirty data is
+    // also written when the cache is destroyed; call end() explicitly to check that the flush succeeded.
+    ResultCode end(void);
+
+    bool isInitialized(void) const;
+    uint8_t lineCount(void) const;
+    uint16_t lineSize(void) const;
+    uint8_t dirtyLineCount(void) const;
+    const Statistics& statistics(void) const;
+    void resetStatistics(void);
+
+    // Linear addressing, see FramI2C.
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data);
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data);
+
+    ResultCode flush(void);
+
+    // Flushes the cache if data has been in the cache for longer than the flush interval,
+    // measured from the write that made the cache dirty. Should be called regularly, e.g. from loop().
+    ResultCode poll(const uint32_t currentMillis);
+#if defined(ARDUINO)
+    ResultCode poll(void);
+#endif
+
+
+    template<typename T> ResultCode read(const uint32_t address, T& t)
+    {
+        // Generic read method, see FramI2C.
+        // If the read fails the value of t is undefined.
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        return readBytes(address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
+    }
+
+
+    template<typename T> ResultCode write(const uint32_t address, const T& t)
+    {
+        // Generic write method, see FramI2C.
+        static_assert(__is_trivially_copyable(T), "write() requires a trivially copyable type");
+        return writeBytes(address, sizeof(T), reinterpret_cast<const uint8_t*>(&t));
+    }
+
+
+private:
+
+    static const uint32_t NoTag = 0xFFFFFFFF;
+
+    struct Line
+    {
+        uint32_t tag;           // FRAM address of the first byte of the line (NoTag if unused).
+        uint16_t dirtyStart;    // Dirty range within the line: dirtyStart <= offset < dirtyEnd.
+        uint16_t dirtyEnd;
+    };
+
+    FramI2C* fram_ = nullptr;
+    Line* lines_ = nullptr;
+    uint8_t* data_ = nullptr;           // lineCount_ * lineSize_ bytes.
+    uint8_t* chunkBuffer_ = nullptr;    // Staging buffer for writing merged lines, one I2C chunk in size.
+    size_t chunkSize_ = 0;
+    uint8_t lineCount_ = 0;
+    uint16_t lineSize_ = 0;
+    uint32_t flushIntervalMs_ = 0;
+    uint32_t dirtySinceMillis_ = 0;     // Time of the write that made the cache dirty.
+    uint32_t lastPollMillis_ = 0;       // currentMillis of the last poll().
+    bool timerStarted_ = false;
+    Statistics statistics_ = {0, 0, 0};
+    bool initialized_ = false;
+
+    Line* findLine(const uint32_t tag) const;
+    Line* allocateLine(const uint32_t tag);
+    uint32_t currentMillis(void) const;
+    uint8_t* lineData(const Line* const line) const;
+    ResultCode writeRun(const uint32_t address, const uint32_t endAddress);
+};
+
+#endif  //FRAMWRITECACHE_H_
@@ -0,0 +1,305 @@
+/* FramWriteQueue.cpp
+ *
+ * Description:  Write request queue for FramI2C that coalesces adjacent and overlapping writes.
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#include "FramWriteQueue.h"
+
+
+// --- Public -----------------------------------------------------------------
+
+FramWriteQueue::FramWriteQueue()
+{
+    // Empty. All initialization is done in begin().
+}
+
+
+FramWriteQueue::~FramWriteQueue()
+{
+    free(requests_);
+    free(order_);
+    free(data_);
+    free(chunkBuffer_);
+}
+
+
+FramWriteQueue::ResultCode FramWriteQueue::begin(FramI2C& fram, const uint8_t maxRequestCount, const size_t dataSize)
+{
+    if (initialized_)
+    {
+        return FramI2C::ResultCode::AllreadyInitializedError;
+    }
+    if (!fram.isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (maxRequestCount == 0 || dataSize == 0)
+    {
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    chunkSize_ = fram.i2cBufferLength() - fram.addressBytesCount();
+    requests_ = static_cast<Request*>(malloc(maxRequestCount * sizeof(Request)));
+    order_ = static_cast<uint8_t*>(malloc(maxRequestCount));
+    data_ = static_cast<uint8_t*>(malloc(dataSize));
+    chunkBuffer_ = static_cast<uint8_t*>(malloc(chunkSize_));
+    if (requests_ == nullptr || order_ == nullptr || data_ == nullptr || chunkBuffer_ == nullptr)
+    {
+        free(requests_);
+        free(order_);
+        free(data_);
+        free(chunkBuffer_);
+        requests_ = nullptr;
+        order_ = nullptr;
+        data_ = nullptr;
+        chunkBuffer_ = nullptr;
+        return FramI2C::ResultCode::BufferAllocationFailedError;
+    }
+
+    fram_ = &fram;
+    maxRequestCount_ = maxRequestCount;
+    dataSize_ = dataSize;
+    clear();
+    resetStatistics();
+    initialized_ = true;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+FramWriteQueue::ResultCode FramWriteQueue::end(void)
+{
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::Success;
+    }
+
+    ResultCode resultcode = commit();
+    free(requests_);
+    free(order_);
+    free(data_);
+    free(chunkBuffer_);
+    requests_ = nullptr;
+    order_ = nullptr;
+    data_ = nullptr;
+    chunkBuffer_ = nullptr;
+    fram_ = nullptr;
+    maxRequestCount_ = 0;
+    dataSize_ = 0;
+    initialized_ = false;
+    return resultcode;
+}
+
+
+bool FramWriteQueue::isInitialized(void) const
+{
+    return initialized_;
+}
+
+
+uint8_t FramWriteQueue::pendingCount(void) const
+{
+    return requestCount_;
+}
+
+
+const FramWriteQueue::Statistics& FramWriteQueue::statistics(void) const
+{
+    return statistics_;
+}
+
+
+void FramWriteQueue::resetStatistics(void)
+{
+    statistics_.requestCount = 0;
+    statistics_.supersededCount = 0;
+    statistics_.transactionCount = 0;
+}
+
+
+FramWriteQueue::ResultCode FramWriteQueue::writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data)
+{
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    if (data == nullptr)
+    {
+        return FramI2C::ResultCode::NullPtrError;
+    }
+    if ((address >= fram_->memorySize()) || byteCount > (fram_->memorySize() - address))
+    {
+        return FramI2C::ResultCode::MemoryRangeError;
+    }
+    if (byteCount > dataSize_)
+    {
+        return FramI2C::ResultCode::BufferOverflowError;
+    }
+    if (byteCount == 0)
+    {
+        return FramI2C::ResultCode::Success;
+    }
+
+    if (requestCount_ == maxRequestCount_ || byteCount > dataSize_ - dataUsed_)
+    {
+        ResultCode resultcode = commit();
+        if (resultcode != FramI2C::ResultCode::Success)
+        {
+            return resultcode;
+        }
+    }
+
+    // Earlier writes that are completely overwritten by this write are dropped.
+    const uint32_t endAddress = address + byteCount;
+    for (uint8_t i = 0; i < requestCount_; ++i)
+    {
+        Request& request = requests_[i];
+        if (request.byteCount > 0 && request.address >= address && request.address + request.byteCount <= endAddress)
+        {
+            request.byteCount = 0;
+            ++statistics_.supersededCount;
+        }
+    }
+
+    Request& request = requests_[requestCount_++];
+    request.address = address;
+    request.byteCount = byteCount;
+    request.dataOffset = dataUsed_;
+    memcpy(data_ + dataUsed_, data, byteCount);
+    dataUsed_ += byteCount;
+    ++statistics_.requestCount;
+
+    return FramI2C::ResultCode::Success;
+}
+
+
+FramWriteQueue::ResultCode FramWriteQueue::readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data) const
+{
+    // Reads byteCount bytes from FRAM, overlaid with the pending writes.
+
+    if (!initialized_)
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+    ResultCode resultcode = fram_->readBytes(address, byteCount, data);
+    if (resultcode == FramI2C::ResultCode::Success)
+    {
+        overlay(address, byteCount, data);
+    }
+    return resultcode;
+}
+
+
+FramWriteQueue::ResultCode FramWriteQueue::commit(void)
+{
+    // Sorts the pending writes by address, merges writes that overlap or are adjacent into ranges
+    // and writes each range. If a write fails, the pending writes are kept (commit() can be retried).
+
+    if (!initialized_ || !fram_->isInitialized())
+    {
+        return FramI2C::ResultCode::NotInitializedError;
+    }
+
+    // Insertion sort of the (non superseded) request indices by address. The number of requests is small.
+    uint8_t sortedCount = 0;
+    for (uint8_t i = 0; i < requestCount_; ++i)
+    {
+        if (requests_[i].byteCount == 0)
+        {
+            continue;
+        }
+        uint8_t j = sortedCount++;
+        while (j > 0 && requests_[order_[j - 1]].address > requests_[i].address)
+        {
+            order_[j] = order_[j - 1];
+            --j;
+        }
+        order_[j] = i;
+    }
+
+    uint8_t i = 0;
+    while (i < sortedCount)
+    {
+        uint32_t rangeStart = requests_[order_[i]].address;
+        uint32_t rangeEnd = rangeStart + requests_[order_[i]].byteCount;
+        ++i;
+        while (i < sortedCount && requests_[order_[i]].address <= rangeEnd)
+        {
+            uint32_t requestEnd = requests_[order_[i]].address + requests_[order_[i]].byteCount;
+            rangeEnd = (requestEnd > rangeEnd) ? requestEnd : rangeEnd;
+            ++i;
+        }
+        ResultCode resultcode = writeRange(rangeStart, rangeEnd);
+        if (resultcode != FramI2C::ResultCode::Success)
+        {
+            return resultcode;
+        }
+    }
+
+    clear();
+    return FramI2C::ResultCode::Success;
+}
+
+
+void FramWriteQueue::clear(void)
+{
+    requestCount_ = 0;
+    dataUsed_ = 0;
+}
+
+
+// --- Private ----------------------------------------------------------------
+
+void FramWriteQueue::overlay(const uint32_t address, const size_t byteCount, uint8_t* const data) const
+{
+    // Copies the pending data within address..address + byteCount - 1 over data.
+    // Requests are applied in the order in which they were queued, so the most recent write wins.
+
+    const uint32_t endAddress = address + byteCount;
+    for (uint8_t i = 0; i < requestCount_; ++i)
+    {
+        const Request& request = requests_[i];
+        uint32_t requestEnd = request.address + request.byteCount;
+        uint32_t overlapStart = (address > request.address) ? address : request.address;
+        uint32_t overlapEnd = (endAddress < requestEnd) ? endAddress : requestEnd;
+        if (overlapStart < overlapEnd)
+        {
+            memcpy(data + (overlapStart - address), data_ + request.dataOffset + (overlapStart - request.address), overlapEnd - overlapStart);
+        }
+    }
+}
+
+
+FramWriteQueue::ResultCode FramWriteQueue::writeRange(const uint32_t address, const uint32_t endAddress)
+{
+    // Writes the merged range in chunks that fit a single I2C transaction and do not cross a page boundary.
+    // Every byte in the range is covered by at least one pending write, so each chunk is completely
+    // assembled from the pending data.
+
+    const uint32_t pageSize = fram_->pageSize();
+    uint32_t chunkAddress = address;
+    while (chunkAddress < endAddress)
+    {
+        uint32_t bytesToPageEnd = pageSize - (chunkAddress % pageSize);
+        uint32_t bytesRemaining = endAddress - chunkAddress;
+        size_t chunkSize = (bytesRemaining < chunkSize_) ? static_cast<size_t>(bytesRemaining) : chunkSize_;
+        chunkSize = (chunkSize < bytesToPageEnd) ? chunkSize : static_cast<size_t>(bytesToPageEnd);
+
+        overlay(chunkAddress, chunkSize, chunkBuffer_);
+        ResultCode resultcode = fram_->writeBytes(chunkAddress, chunkSize, chunkBuffer_);
+        ++statistics_.transactionCount;
+        if (resultcode != FramI2C::ResultCode::Success)
+        {
+            return resultcode;
+        }
+        chunkAddress += chunkSize;
+    }
+    return FramI2C::ResultCode::Success;
+}
+
+
+/* eof */
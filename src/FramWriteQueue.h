@@ -0,0 +1,125 @@
+/* FramWriteQueue.h
+ *
+ * Description:  Write request queue for FramI2C that coalesces small writes.
+ *               writeBytes() copies the data into the queue. commit() sorts the pending writes by
+ *               address, merges adjacent and overlapping writes (the most recent write wins where
+ *               writes overlap) and writes each merged range with as few maximum size I2C transactions
+ *               as possible. Writes that are completely overwritten by a later write are dropped
+ *               without being transferred.
+ *
+ *               Typical use: queue all writes of one loop iteration and commit() at the end.
+ *               readBytes() returns FRAM data overlaid with the pending writes.
+ *
+ *               Example usage:
+ *                 FramWriteQueue writeQueue;
+ *                 writeQueue.begin(fram, 16, 256);    // Max 16 pending writes, 256 bytes of data.
+ *                 ...
+ *                 void loop()
+ *                 {
+ *                     writeQueue.write(0x10, setpoint);
+ *                     writeQueue.write(0x14, output);
+ *                     writeQueue.commit();            // Single I2C transaction.
+ *                 }
+ *
+ * Author:       Leonel Lopes Parente
+ * License:      MIT (see LICENSE file in repository root)
+ *
+ */
+
+#ifndef FRAMWRITEQUEUE_H_
+#define FRAMWRITEQUEUE_H_
+
+#include "FramI2C.h"
+
+
+class FramWriteQueue
+{
+
+public:
+
+    typedef FramI2C::ResultCode ResultCode;
+
+    struct Statistics
+    {
+        uint32_t requestCount;          // Number of queued writes.
+        uint32_t supersededCount;       // Number of writes dropped because a later write overwrote them completely.
+        uint32_t transactionCount;      // Number of I2C write transactions issued by commit().
+
+        // Average number of queued writes per I2C transaction.
+        float coalescingRatio(void) const
+        {
+            return (transactionCount > 0) ? static_cast<float>(requestCount) / transactionCount : 0.0f;
+        }
+    };
+
+    FramWriteQueue();
+    ~FramWriteQueue();
+
+    // fram must be initialized. maxRequestCount is the maximum number of pending writes,
+    // dataSize the total number of bytes that pending writes can hold.
+    ResultCode begin(FramI2C& fram, const uint8_t maxRequestCount = 16, const size_t dataSize = 256);
+
+    // Commits pending writes and frees the allocated memory.
+    // The destructor does not commit, pending writes are lost if end() (or commit()) is not called.
+    ResultCode end(void);
+
+    bool isInitialized(void) const;
+    uint8_t pendingCount(void) const;
+    const Statistics& statistics(void) const;
+    void resetStatistics(void);
+
+    // Linear addressing, see FramI2C.
+    // If the queue is full, pending writes are committed first.
+    // Returns BufferOverflowError if byteCount is larger than dataSize.
+    ResultCode writeBytes(const uint32_t address, const size_t byteCount, const uint8_t* const data);
+    ResultCode readBytes(const uint32_t address, const size_t byteCount, uint8_t* const data) const;
+
+    ResultCode commit(void);
+
+    // Discards all pending writes.
+    void clear(void);
+
+
+    template<typename T> ResultCode read(const uint32_t address, T& t) const
+    {
+        // Generic read method, see FramI2C.
+        static_assert(__is_trivially_copyable(T), "read() requires a trivially copyable type");
+        return readBytes(address, sizeof(T), reinterpret_cast<uint8_t*>(&t));
+    }
+
+
+    template<typename T> ResultCode write(const uint32_t address, const T& t)
+    {
+        // Generic write method, see FramI2C.
+        static_assert(__is_trivially_copyable(T), "write() requires a trivially copyable type");
+        return writeBytes(address, sizeof(T), reinterpret_cast<const uint8_t*>(&t));
+    }
+
+
+private:
+
+    struct Request
+    {
+        uint32_t address;
+        size_t byteCount;       // 0 if superseded.
+        size_t dataOffset;      // Offset of the request's data in data_.
+    };
+
+    FramI2C* fram_ = nullptr;
+    Request* requests_ = nullptr;   // In the order in which they were queued.
+    uint8_t* order_ = nullptr;      // Request indices sorted by address (built by commit()).
+    uint8_t* data_ = nullptr;
+    uint8_t* chunkBuffer_ = nullptr;
+    size_t chunkSize_ = 0;
+    uint8_t maxRequestCount_ = 0;
+    uint8_t requestCount_ = 0;
+    size_t dataSize_ = 0;
+    size_t dataUsed_ = 0;
+    Statistics statistics_ = {0, 0, 0};
+    bool initialized_ = false;
+
+    void overlay(const uint32_t address, const size_t byteCount, uint8_t* const data) const;
+    ResultCode writeRange(const uint32_t address, const uint32_t endAddress);
+};
+
+#endif  //FRAMWRITEQUEUE_H_